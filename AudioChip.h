@@ -25,7 +25,10 @@ SOFTWARE.
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <vector>
+#include "AudioChipCore.h"
+#include "Resampler.h"
 
 
 namespace AudioChip {
@@ -33,15 +36,35 @@ namespace AudioChip {
 
 class AudioChip {
 public:
-	enum class WaveformType {Sine, Square, Noise, Saw};
+	using WaveformType = ::AudioChip::WaveformType;
+	using Activity = ::AudioChip::Activity;
 
 	AudioChip() = delete;
 	AudioChip(const uint32_t inSampleRate, const uint32_t inNumTracks);
 
 	/**
-		Render inNumSamples samples to outBuffer.
+		Synthesize at inInternalSampleRate and resample the mixed output to inSampleRate. A lower internal rate
+		reduces both the number of harmonics of the additive waveforms and the number of rendered samples.
+		renderNextSamples() must not be called with more than inMaxNumSamples samples, so that it never allocates.
 	*/
-	void renderNextSamples(float* outBuffer, const uint32_t inNumSamples);
+	AudioChip(const uint32_t inSampleRate, const uint32_t inNumTracks, const uint32_t inInternalSampleRate, const Resampler::Quality inResamplerQuality, const uint32_t inMaxNumSamples);
+
+	/**
+		Render inNumSamples samples to outBuffer. Returns the activity of the rendered buffer. When resampling,
+		buffers that are not silent are reported as Activity::Active.
+	*/
+	Activity renderNextSamples(float* outBuffer, const uint32_t inNumSamples);
+
+	/**
+		Get the activity of inTrack during the last call to renderNextSamples().
+	*/
+	Activity getTrackActivity(const uint32_t inTrack) const;
+
+	/**
+		When enabled, renderNextSamples() leaves outBuffer untouched instead of clearing it when the rendered
+		buffer is silent. Disabled by default.
+	*/
+	void setSkipSilentOutput(const bool inSkipSilentOutput);
 
 	/**
 		Reset the envelope of inTrack and enable the track.
@@ -59,7 +82,8 @@ public:
 	void setFrequency(const uint32_t inTrack, const float inFrequency);
 
 	/**
-		Set wave form to any of WaveformType::Sine, WaveformType::Square, WaveformType::Noise or WaveformType::Saw.
+		Set wave form to any of WaveformType::Sine, WaveformType::Square, WaveformType::Noise, WaveformType::Saw or
+		WaveformType::Sample.
 	*/
 	void setWaveformType(const uint32_t inTrack, const WaveformType inWaveformType);
 
@@ -79,40 +103,32 @@ public:
 	*/
 	void disablePWM(const uint32_t inTrack);
 
-private:
-	typedef float (*waveformGenerator)(const float inPhase, const uint32_t inHighestSubharmonic, const float inPWMPhaseOffset);
-
-	struct Track {
-		struct EnvelopeData {
-			enum class State {Attack, Decay, Sustain, Release};
-
-			uint8_t attack;
-			uint8_t decay;
-			uint8_t sustain;
-			uint8_t release;
-			float currentFactor;
-			enum State state;
-		};
-
-		EnvelopeData envelope;
-		bool enabled;
-
-		float phase;
-		float phaseIncrement;
-		uint32_t highestSubharmonic;
+	/**
+		Set the sample played by the WaveformType::Sample waveform and disable its loop. The sample plays at its own
+		sample rate when the track frequency is inBaseFrequency and is pitched relative to that otherwise.
+	*/
+	void setSample(const uint32_t inTrack, const std::shared_ptr<const SampleAsset>& inSample, const float inBaseFrequency);
 
-		float pwmPhase;
-		float pwmPhaseIncrement;
-		float pwmDepth;
+	/**
+		Loop the sample between the frames inLoopStart and inLoopEnd, exclusive, once playback reaches inLoopEnd.
+	*/
+	void enableSampleLoop(const uint32_t inTrack, const uint32_t inLoopStart, const uint32_t inLoopEnd);
 
-		waveformGenerator generator;
-	};
+	/**
+		Disable the sample loop. The note ends when the sample has played to the end.
+	*/
+	void disableSampleLoop(const uint32_t inTrack);
 
-	bool advanceEnvelope(const uint32_t inTrack, const uint32_t inAdvanceSamples);
+private:
+	Activity renderTracks(float* outBuffer, const uint32_t inNumSamples, const bool inSkipSilentOutput);
 
 	uint32_t sampleRate;
 	uint32_t numTracks;
-	std::vector<Track> tracks;
+	bool skipSilentOutput;
+	std::vector<detail::Track> tracks;
+
+	std::unique_ptr<Resampler> resampler;
+	std::vector<float> internalBuffer;
 };
 
 
@@ -0,0 +1,696 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <assert.h>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include "SampleAsset.h"
+#include "SineTable.h"
+
+
+namespace AudioChip {
+
+
+enum class WaveformType {Sine, Square, Noise, Saw, Sample};
+
+/**
+	Activity of a rendered buffer or track. Silent means every sample is zero, Constant means every sample
+	has the same value and Active means the samples vary. A track is only Constant when its frequency is a
+	multiple of the sample rate, which samples the waveform at the same phase every time.
+*/
+enum class Activity {Silent, Constant, Active};
+
+/**
+	Optional features of BasicAudioChip. Code for features that are not enabled is stripped at compile time.
+	The sine waveform is always available.
+*/
+namespace Feature {
+	constexpr uint32_t Square = 1 << 0;
+	constexpr uint32_t Noise = 1 << 1;
+	constexpr uint32_t Saw = 1 << 2;
+	constexpr uint32_t PWM = 1 << 3;
+	constexpr uint32_t Sample = 1 << 4;
+	constexpr uint32_t All = Square | Noise | Saw | PWM | Sample;
+} // namespace Feature
+
+
+namespace detail {
+
+
+inline SineTable sineTable;
+
+
+constexpr uint32_t envelopeMaxParameterValue = 126;
+constexpr float envelopeMaxStageTimeMs = 10000.0f;
+constexpr float initFrequency = 440.0f;
+
+constexpr float pi2 = M_PI * 2.0f;
+constexpr float envelopeFactorPerStep = 1.0f / static_cast<float>(envelopeMaxParameterValue + 1);
+constexpr float envelopeTimePerStep = envelopeMaxStageTimeMs / static_cast<float>(envelopeMaxParameterValue + 1);
+
+
+constexpr float samplesToTimeMs(const uint32_t inNumSamples, const uint32_t inSampleRate) {
+	return static_cast<float>(inNumSamples) / (static_cast<float>(inSampleRate) / 1000.0f);
+}
+
+
+inline uint32_t calcHighestSubharmonic(const float inFrequency, const uint32_t inSampleRate) {
+	const float halfSampleRate = inSampleRate / 2.0f;
+
+	uint32_t highestSubharmonic = 1;
+	while ((inFrequency * static_cast<float>(highestSubharmonic)) < halfSampleRate) {
+		++highestSubharmonic;
+	}
+	return highestSubharmonic - 1;
+}
+
+
+constexpr float frequencyToPhaseIncrement(const float inFrequency, const float inSampleRate) {
+	return (pi2 * inFrequency) / inSampleRate;
+}
+
+
+/**
+	Phase increment of a note wrapped into one period. Frequencies within rounding of a multiple of the sample
+	rate get an increment of exactly zero, so that they render as the constant they are instead of drifting.
+*/
+inline float noteFrequencyToPhaseIncrement(const float inFrequency, const uint32_t inSampleRate) {
+	const float phaseIncrementTolerance = 8.0f * FLT_EPSILON * pi2;
+
+	const float phaseIncrement = fmodf(frequencyToPhaseIncrement(inFrequency, inSampleRate), pi2);
+	if (phaseIncrement < phaseIncrementTolerance || pi2 - phaseIncrement < phaseIncrementTolerance) {
+		return 0.0f;
+	}
+	return phaseIncrement;
+}
+
+
+inline float sineGenerator(const float inPhase, const uint32_t /*inHighestSubharmonic*/, const float /*inPWMPhaseOffset*/) {
+	assert(inPhase >= 0.0f);
+	return sineTable.lookupSinf(inPhase);
+}
+
+
+inline float squareGenerator(const float inPhase, const uint32_t inHighestSubharmonic, const float inPWMPhaseOffset) {
+	assert(inPhase >= 0.0f);
+
+	float outSample = 0.0f;
+
+	if (inPWMPhaseOffset == 0.0f) {
+		for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; freqMultiplier += 2) {
+			const float freqMultiplierFloat = static_cast<float>(freqMultiplier);
+			outSample += sineTable.lookupSinf(inPhase * freqMultiplierFloat) / freqMultiplierFloat;
+		}
+	} else {
+		float saw1Sample = 0.0f;
+		float saw2Sample = 0.0f;
+
+		const float offsetPhase = inPhase + inPWMPhaseOffset;
+
+		// Saw
+		for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; ++freqMultiplier) {
+			const float freqMultiplierFloat = static_cast<float>(freqMultiplier);
+			saw1Sample += sineTable.lookupSinf(inPhase * freqMultiplierFloat) / freqMultiplierFloat;
+		}
+
+		// Inverted saw
+		for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; freqMultiplier += 2) {
+			const float freqMultiplierFloat = static_cast<float>(freqMultiplier);
+			saw2Sample -= sineTable.lookupSinf(offsetPhase * freqMultiplierFloat) / freqMultiplierFloat;
+		}
+		for (uint32_t freqMultiplier = 2; freqMultiplier <= inHighestSubharmonic; freqMultiplier += 2) {
+			const float freqMultiplierFloat = static_cast<float>(freqMultiplier);
+			saw2Sample += sineTable.lookupSinf(offsetPhase * freqMultiplierFloat) / freqMultiplierFloat;
+		}
+
+		// Pulse wave
+		outSample = saw1Sample - saw2Sample;
+	}
+
+	return outSample;
+}
+
+
+inline float noiseGenerator(const float /*inPhase*/, const uint32_t /*inHighestSubharmonic*/, const float /*inPWMPhaseOffset*/) {
+	return -1.0f + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) / 2.0f);
+}
+
+
+inline float sawGenerator(const float inPhase, const uint32_t inHighestSubharmonic, const float /*inPWMPhaseOffset*/) {
+	assert(inPhase >= 0.0f);
+
+	float outSample = 0.0f;
+	for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; ++freqMultiplier) {
+		const float freqMultiplierFloat = static_cast<float>(freqMultiplier);
+		outSample += sineTable.lookupSinf(inPhase * freqMultiplierFloat) / freqMultiplierFloat;
+	}
+
+	return outSample;
+}
+
+
+typedef float (*WaveformGenerator)(const float inPhase, const uint32_t inHighestSubharmonic, const float inPWMPhaseOffset);
+
+
+struct Track {
+	struct EnvelopeData {
+		enum class State {Attack, Decay, Sustain, Release};
+
+		uint8_t attack;
+		uint8_t decay;
+		uint8_t sustain;
+		uint8_t release;
+		float currentFactor;
+		enum State state;
+	};
+
+	EnvelopeData envelope;
+	bool enabled;
+	Activity activity;
+
+	float frequency;
+	float phase;
+	float phaseIncrement;
+	uint32_t highestSubharmonic;
+
+	float pwmPhase;
+	float pwmPhaseIncrement;
+	float pwmDepth;
+
+	WaveformType waveformType;
+
+	std::shared_ptr<const SampleAsset> sample;
+	float sampleBaseFrequency;
+	double samplePosition;
+	double samplePositionIncrement;
+	uint32_t sampleLoopStart;
+	uint32_t sampleLoopEnd;
+};
+
+
+inline void initTrack(Track& outTrack, const uint32_t inSampleRate) {
+	outTrack.envelope.attack = 0;
+	outTrack.envelope.decay = 0;
+	outTrack.envelope.sustain = envelopeMaxParameterValue;
+	outTrack.envelope.release = 0;
+	outTrack.envelope.currentFactor = 0.0f;
+	outTrack.envelope.state = Track::EnvelopeData::State::Attack;
+	outTrack.enabled = false;
+	outTrack.activity = Activity::Silent;
+
+	outTrack.frequency = initFrequency;
+	outTrack.phase = 0.0f;
+	outTrack.phaseIncrement = noteFrequencyToPhaseIncrement(initFrequency, inSampleRate);
+	outTrack.highestSubharmonic = calcHighestSubharmonic(initFrequency, inSampleRate);
+
+	outTrack.pwmPhase = 0.0f;
+	outTrack.pwmPhaseIncrement = 0.0f;
+	outTrack.pwmDepth = 0.0f;
+
+	outTrack.waveformType = WaveformType::Sine;
+
+	outTrack.sample.reset();
+	outTrack.sampleBaseFrequency = initFrequency;
+	outTrack.samplePosition = 0.0;
+	outTrack.samplePositionIncrement = 0.0;
+	outTrack.sampleLoopStart = 0;
+	outTrack.sampleLoopEnd = 0;
+}
+
+
+inline void updateSamplePositionIncrement(Track& ioTrack, const uint32_t inSampleRate) {
+	if (!ioTrack.sample) {
+		ioTrack.samplePositionIncrement = 0.0;
+		return;
+	}
+
+	const double pitchFactor = static_cast<double>(ioTrack.frequency) / static_cast<double>(ioTrack.sampleBaseFrequency);
+	ioTrack.samplePositionIncrement = pitchFactor * ioTrack.sample->getSampleRate() / static_cast<double>(inSampleRate);
+}
+
+
+inline void noteOn(Track& ioTrack) {
+	ioTrack.envelope.currentFactor = 0.0f;
+	ioTrack.envelope.state = Track::EnvelopeData::State::Attack;
+	ioTrack.enabled = true;
+	ioTrack.samplePosition = 0.0;
+}
+
+
+inline void noteOff(Track& ioTrack) {
+	ioTrack.envelope.state = Track::EnvelopeData::State::Release;
+}
+
+
+inline void setFrequency(Track& ioTrack, const float inFrequency, const uint32_t inSampleRate) {
+	assert(inFrequency > 0.0f);
+
+	ioTrack.frequency = inFrequency;
+	ioTrack.phase = 0.0f;
+	ioTrack.phaseIncrement = noteFrequencyToPhaseIncrement(inFrequency, inSampleRate);
+	ioTrack.highestSubharmonic = calcHighestSubharmonic(inFrequency, inSampleRate);
+	updateSamplePositionIncrement(ioTrack, inSampleRate);
+}
+
+
+template<uint32_t Features>
+void setWaveformType(Track& ioTrack, const WaveformType inWaveformType) {
+	switch (inWaveformType) {
+	case WaveformType::Sine:
+		break;
+	case WaveformType::Square:
+		if constexpr ((Features & Feature::Square) == 0) {
+			assert(false);
+			return;
+		}
+		break;
+	case WaveformType::Noise:
+		if constexpr ((Features & Feature::Noise) == 0) {
+			assert(false);
+			return;
+		}
+		break;
+	case WaveformType::Saw:
+		if constexpr ((Features & Feature::Saw) == 0) {
+			assert(false);
+			return;
+		}
+		break;
+	case WaveformType::Sample:
+		if constexpr ((Features & Feature::Sample) == 0) {
+			assert(false);
+			return;
+		}
+		break;
+	default:
+		assert(false);
+		return;
+	}
+
+	ioTrack.waveformType = inWaveformType;
+}
+
+
+inline void setEnvelope(Track& ioTrack, const uint8_t inAttack, const uint8_t inDecay, const uint8_t inSustain, const uint8_t inRelease) {
+	assert(inAttack <= envelopeMaxParameterValue);
+	assert(inDecay <= envelopeMaxParameterValue);
+	assert(inSustain <= envelopeMaxParameterValue);
+	assert(inRelease <= envelopeMaxParameterValue);
+
+	ioTrack.envelope.attack = inAttack;
+	ioTrack.envelope.decay = inDecay;
+	ioTrack.envelope.sustain = inSustain;
+	ioTrack.envelope.release = inRelease;
+}
+
+
+inline void enablePWM(Track& ioTrack, const float inFrequency, const float inPWMDepth, const uint32_t inSampleRate) {
+	assert(inPWMDepth > 0.0f && inPWMDepth <= 1.0f);
+
+	ioTrack.pwmPhase = 0.0f;
+	ioTrack.pwmPhaseIncrement = frequencyToPhaseIncrement(inFrequency, inSampleRate);
+	ioTrack.pwmDepth = inPWMDepth;
+}
+
+
+inline void disablePWM(Track& ioTrack) {
+	ioTrack.pwmDepth = 0.0f;
+}
+
+
+inline void setSample(Track& ioTrack, const std::shared_ptr<const SampleAsset>& inSample, const float inBaseFrequency, const uint32_t inSampleRate) {
+	assert(inBaseFrequency > 0.0f);
+
+	ioTrack.sample = inSample;
+	ioTrack.sampleBaseFrequency = inBaseFrequency;
+	ioTrack.samplePosition = 0.0;
+	ioTrack.sampleLoopStart = 0;
+	ioTrack.sampleLoopEnd = 0;
+	updateSamplePositionIncrement(ioTrack, inSampleRate);
+}
+
+
+inline void enableSampleLoop(Track& ioTrack, const uint32_t inLoopStart, const uint32_t inLoopEnd) {
+	assert(ioTrack.sample);
+	assert(inLoopStart < inLoopEnd);
+	assert(inLoopEnd <= ioTrack.sample->getNumFrames());
+
+	ioTrack.sampleLoopStart = inLoopStart;
+	ioTrack.sampleLoopEnd = inLoopEnd;
+}
+
+
+inline void disableSampleLoop(Track& ioTrack) {
+	ioTrack.sampleLoopStart = 0;
+	ioTrack.sampleLoopEnd = 0;
+}
+
+
+inline bool advanceEnvelope(Track::EnvelopeData& ioEnvelope, const uint32_t inAdvanceSamples, const uint32_t inSampleRate) {
+	const float elapsedTimeMs = samplesToTimeMs(inAdvanceSamples, inSampleRate);
+	float factorPerMs = 0.0f;
+
+	switch (ioEnvelope.state) {
+	case Track::EnvelopeData::State::Attack:
+		if (ioEnvelope.attack == 0) {
+			factorPerMs = 1.0f;
+		} else {
+			factorPerMs = 1.0f / (envelopeTimePerStep * ioEnvelope.attack);
+		}
+		ioEnvelope.currentFactor += factorPerMs * elapsedTimeMs;
+		if (ioEnvelope.currentFactor >= 1.0f) {
+			ioEnvelope.currentFactor = 1.0f;
+			ioEnvelope.state = Track::EnvelopeData::State::Decay;
+		}
+		break;
+	case Track::EnvelopeData::State::Decay:
+		if (ioEnvelope.decay == 0) {
+			factorPerMs = 1.0f;
+		} else {
+			factorPerMs = 1.0f / (envelopeTimePerStep * ioEnvelope.decay);
+		}
+
+		ioEnvelope.currentFactor -= factorPerMs * elapsedTimeMs;
+		{
+			const float sustainFactor = ioEnvelope.sustain * envelopeFactorPerStep;
+			if (ioEnvelope.currentFactor <= sustainFactor) {
+				ioEnvelope.currentFactor = sustainFactor;
+				ioEnvelope.state = Track::EnvelopeData::State::Sustain;
+			}
+		}
+		break;
+	case Track::EnvelopeData::State::Sustain:
+		if (ioEnvelope.sustain == envelopeMaxParameterValue) {
+			ioEnvelope.currentFactor = 1.0f;
+		} else {
+			ioEnvelope.currentFactor = ioEnvelope.sustain * envelopeFactorPerStep;
+		}
+		break;
+	case Track::EnvelopeData::State::Release:
+		if (ioEnvelope.release == 0) {
+			ioEnvelope.currentFactor = 0.0f;
+			return true;
+		} else {
+			factorPerMs = 1.0f / (envelopeTimePerStep * ioEnvelope.release);
+
+			ioEnvelope.currentFactor -= factorPerMs * elapsedTimeMs;
+			if (ioEnvelope.currentFactor <= 0.0f) {
+				ioEnvelope.currentFactor = 0.0f;
+				return true;
+			}
+		}
+		break;
+	default:
+		assert(0);
+	}
+
+	assert(ioEnvelope.currentFactor >= 0.0f && ioEnvelope.currentFactor <= 1.0f);
+	return false;
+}
+
+
+inline Activity calcTrackActivity(const Track& inTrack) {
+	if (inTrack.envelope.currentFactor == 0.0f) {
+		return Activity::Silent;
+	}
+
+	if (inTrack.waveformType == WaveformType::Noise) {
+		return Activity::Active;
+	}
+
+	if (inTrack.waveformType == WaveformType::Sample) {
+		return inTrack.sample ? Activity::Active : Activity::Silent;
+	}
+
+	// The additive generators sum no harmonics at all when the note is above Nyquist
+	if ((inTrack.waveformType == WaveformType::Square || inTrack.waveformType == WaveformType::Saw) && inTrack.highestSubharmonic == 0) {
+		return Activity::Silent;
+	}
+
+	// A frequency at a multiple of the sample rate samples the waveform at the same phase every time
+	if (inTrack.pwmDepth == 0.0f && inTrack.phaseIncrement == 0.0f) {
+		return Activity::Constant;
+	}
+
+	return Activity::Active;
+}
+
+
+/**
+	Advance the envelope of ioTrack by inNumSamples and update its activity for the coming block.
+*/
+inline Activity prepareTrack(Track& ioTrack, const uint32_t inNumSamples, const uint32_t inSampleRate) {
+	ioTrack.activity = Activity::Silent;
+
+	if (!ioTrack.enabled) {
+		return ioTrack.activity;
+	}
+
+	const bool noteEnded = advanceEnvelope(ioTrack.envelope, inNumSamples, inSampleRate);
+	if (noteEnded) {
+		ioTrack.enabled = false;
+		return ioTrack.activity;
+	}
+
+	ioTrack.activity = calcTrackActivity(ioTrack);
+	return ioTrack.activity;
+}
+
+
+/**
+	Wrap the sample position of ioTrack into its loop, or end the note when a sample without a loop has played
+	to the end. Returns false if the note ended.
+*/
+inline bool wrapSamplePosition(Track& ioTrack) {
+	const bool looping = ioTrack.sampleLoopEnd > ioTrack.sampleLoopStart;
+	const uint32_t endFrame = looping ? ioTrack.sampleLoopEnd : ioTrack.sample->getNumFrames();
+
+	if (ioTrack.samplePosition < endFrame) {
+		return true;
+	}
+
+	if (!looping) {
+		ioTrack.enabled = false;
+		return false;
+	}
+
+	const double loopLength = ioTrack.sampleLoopEnd - ioTrack.sampleLoopStart;
+	ioTrack.samplePosition = ioTrack.sampleLoopStart + fmod(ioTrack.samplePosition - ioTrack.sampleLoopStart, loopLength);
+	return true;
+}
+
+
+inline void skipTrackSamples(Track& ioTrack, const uint32_t inNumSamples) {
+	const float numSamplesFloat = static_cast<float>(inNumSamples);
+
+	ioTrack.phase = fmodf(ioTrack.phase + ioTrack.phaseIncrement * numSamplesFloat, pi2);
+	if (ioTrack.pwmDepth != 0.0f) {
+		ioTrack.pwmPhase = fmodf(ioTrack.pwmPhase + ioTrack.pwmPhaseIncrement * numSamplesFloat, pi2);
+	}
+
+	if (ioTrack.waveformType == WaveformType::Sample && ioTrack.sample) {
+		ioTrack.samplePosition += ioTrack.samplePositionIncrement * inNumSamples;
+		wrapSamplePosition(ioTrack);
+	}
+}
+
+
+inline float sampleToFloat(const int16_t inSample) {
+	return static_cast<float>(inSample) * (1.0f / 32768.0f);
+}
+
+
+inline float sampleToFloat(const float inSample) {
+	return inSample;
+}
+
+
+/**
+	Add inNumSamples samples of the sample asset of ioTrack to the interleaved outBuffer, reading SampleType
+	frames with SampleChannels channels in place and interpolating linearly between them.
+*/
+template<uint32_t Channels, typename SampleType, uint32_t SampleChannels>
+void renderSampleFrames(Track& ioTrack, const SampleType* inSampleData, float* outBuffer, const uint32_t inNumSamples) {
+	const bool looping = ioTrack.sampleLoopEnd > ioTrack.sampleLoopStart;
+	const uint32_t endFrame = looping ? ioTrack.sampleLoopEnd : ioTrack.sample->getNumFrames();
+	const float gain = ioTrack.envelope.currentFactor;
+
+	for (uint32_t sample = 0; sample < inNumSamples; ++sample) {
+		if (!wrapSamplePosition(ioTrack)) {
+			return;
+		}
+
+		const uint32_t frame = static_cast<uint32_t>(ioTrack.samplePosition);
+		const float fraction = static_cast<float>(ioTrack.samplePosition - frame);
+		uint32_t nextFrame = frame + 1;
+		if (nextFrame >= endFrame) {
+			nextFrame = looping ? ioTrack.sampleLoopStart : frame;
+		}
+
+		float frameData[SampleChannels];
+		for (uint32_t channel = 0; channel < SampleChannels; ++channel) {
+			const float current = sampleToFloat(inSampleData[frame * SampleChannels + channel]);
+			const float next = sampleToFloat(inSampleData[nextFrame * SampleChannels + channel]);
+			frameData[channel] = (current + (next - current) * fraction) * gain;
+		}
+
+		float* outFrame = outBuffer + sample * Channels;
+		if constexpr (SampleChannels == 1) {
+			for (uint32_t channel = 0; channel < Channels; ++channel) {
+				outFrame[channel] += frameData[0];
+			}
+		} else if constexpr (Channels == 1) {
+			outFrame[0] += (frameData[0] + frameData[1]) * 0.5f;
+		} else {
+			for (uint32_t channel = 0; channel < Channels; ++channel) {
+				outFrame[channel] += frameData[channel & 1];
+			}
+		}
+
+		ioTrack.samplePosition += ioTrack.samplePositionIncrement;
+	}
+}
+
+
+template<uint32_t Channels>
+void renderSampleTrack(Track& ioTrack, float* outBuffer, const uint32_t inNumSamples) {
+	const SampleAsset& sample = *ioTrack.sample;
+
+	if (sample.getFormat() == SampleAsset::Format::Int16) {
+		const int16_t* sampleData = static_cast<const int16_t*>(sample.getData());
+		if (sample.getNumChannels() == 1) {
+			renderSampleFrames<Channels, int16_t, 1>(ioTrack, sampleData, outBuffer, inNumSamples);
+		} else {
+			renderSampleFrames<Channels, int16_t, 2>(ioTrack, sampleData, outBuffer, inNumSamples);
+		}
+	} else {
+		const float* sampleData = static_cast<const float*>(sample.getData());
+		if (sample.getNumChannels() == 1) {
+			renderSampleFrames<Channels, float, 1>(ioTrack, sampleData, outBuffer, inNumSamples);
+		} else {
+			renderSampleFrames<Channels, float, 2>(ioTrack, sampleData, outBuffer, inNumSamples);
+		}
+	}
+}
+
+
+/**
+	Add inNumSamples samples of a track with an additive or noise waveform to the interleaved outBuffer. The
+	generator is a template argument so that the sample loop calls it directly.
+*/
+template<uint32_t Channels, uint32_t Features, WaveformGenerator Generator>
+void renderGeneratorTrack(Track& ioTrack, float* outBuffer, const uint32_t inNumSamples) {
+	const uint32_t totalSamples = inNumSamples * Channels;
+
+	if (ioTrack.activity == Activity::Constant) {
+		const float constantSampleData = Generator(ioTrack.phase, ioTrack.highestSubharmonic, 0.0f) * ioTrack.envelope.currentFactor;
+		for (uint32_t sample = 0; sample < totalSamples; ++sample) {
+			outBuffer[sample] += constantSampleData;
+		}
+		return;
+	}
+
+	for (uint32_t sample = 0; sample < totalSamples; sample += Channels) {
+		// PWM
+		float pwmPhaseOffset = 0.0f;
+		if constexpr ((Features & Feature::PWM) != 0) {
+			if (ioTrack.pwmDepth != 0.0f) {
+				const float pwmFactor = sineGenerator(ioTrack.pwmPhase, 1, 0.0f) * ioTrack.pwmDepth;
+				pwmPhaseOffset = pwmFactor * M_PI;
+
+				ioTrack.pwmPhase += ioTrack.pwmPhaseIncrement;
+				if (ioTrack.pwmPhase >= pi2) {
+					ioTrack.pwmPhase -= pi2;
+				}
+			}
+		}
+
+		// Add track generator to mix
+		const float currentSampleData = Generator(ioTrack.phase, ioTrack.highestSubharmonic, pwmPhaseOffset) * ioTrack.envelope.currentFactor;
+		for (uint32_t channel = 0; channel < Channels; ++channel) {
+			outBuffer[sample + channel] += currentSampleData;
+		}
+
+		// Update track phase
+		ioTrack.phase += ioTrack.phaseIncrement;
+		if (ioTrack.phase >= pi2) {
+			ioTrack.phase -= pi2;
+		}
+	}
+}
+
+
+/**
+	Add inNumSamples samples of a track prepared by prepareTrack() to the interleaved outBuffer. Waveforms that
+	are not in Features are never rendered, since setWaveformType() does not select them.
+*/
+template<uint32_t Channels, uint32_t Features>
+void renderTrack(Track& ioTrack, float* outBuffer, const uint32_t inNumSamples) {
+	static_assert(Channels > 0, "At least one channel is required");
+
+	if (!ioTrack.enabled) {
+		return;
+	}
+
+	if (ioTrack.activity == Activity::Silent) {
+		skipTrackSamples(ioTrack, inNumSamples);
+		return;
+	}
+
+	switch (ioTrack.waveformType) {
+	case WaveformType::Sine:
+		renderGeneratorTrack<Channels, Features, sineGenerator>(ioTrack, outBuffer, inNumSamples);
+		break;
+	case WaveformType::Square:
+		if constexpr ((Features & Feature::Square) != 0) {
+			renderGeneratorTrack<Channels, Features, squareGenerator>(ioTrack, outBuffer, inNumSamples);
+		}
+		break;
+	case WaveformType::Noise:
+		if constexpr ((Features & Feature::Noise) != 0) {
+			renderGeneratorTrack<Channels, Features, noiseGenerator>(ioTrack, outBuffer, inNumSamples);
+		}
+		break;
+	case WaveformType::Saw:
+		if constexpr ((Features & Feature::Saw) != 0) {
+			renderGeneratorTrack<Channels, Features, sawGenerator>(ioTrack, outBuffer, inNumSamples);
+		}
+		break;
+	case WaveformType::Sample:
+		if constexpr ((Features & Feature::Sample) != 0) {
+			renderSampleTrack<Channels>(ioTrack, outBuffer, inNumSamples);
+		}
+		break;
+	}
+}
+
+
+} // namespace detail
+} // namespace AudioChip
@@ -0,0 +1,207 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "AudioChipCore.h"
+
+
+namespace AudioChip {
+
+
+/**
+	Audio chip with the number of tracks, the number of interleaved output channels and the enabled features
+	fixed at compile time. Tracks are stored inline and all per-track loops are unrolled.
+*/
+template<uint32_t NumTracks, uint32_t Channels = 2, uint32_t Features = Feature::All>
+class BasicAudioChip {
+public:
+	static_assert(NumTracks > 0, "At least one track is required");
+	static_assert(Channels > 0, "At least one channel is required");
+
+	static constexpr uint32_t numTracks = NumTracks;
+	static constexpr uint32_t numChannels = Channels;
+
+	BasicAudioChip() = delete;
+	explicit BasicAudioChip(const uint32_t inSampleRate)
+		: sampleRate(inSampleRate),
+		  skipSilentOutput(false)
+	{
+		forEachTrack([this](detail::Track& track) {
+			detail::initTrack(track, sampleRate);
+		});
+	}
+
+	/**
+		Render inNumSamples samples to outBuffer. Returns the activity of the rendered buffer.
+	*/
+	Activity renderNextSamples(float* outBuffer, const uint32_t inNumSamples) {
+		assert(outBuffer != nullptr);
+
+		// Advance all envelopes first, the activity of the whole buffer must be known before anything is written
+		Activity bufferActivity = Activity::Silent;
+		forEachTrack([this, &bufferActivity, inNumSamples](detail::Track& track) {
+			const Activity trackActivity = detail::prepareTrack(track, inNumSamples, sampleRate);
+			if (trackActivity > bufferActivity) {
+				bufferActivity = trackActivity;
+			}
+		});
+
+		if (bufferActivity != Activity::Silent || !skipSilentOutput) {
+			memset(outBuffer, 0, inNumSamples * Channels * sizeof(float));
+		}
+
+		forEachTrack([outBuffer, inNumSamples](detail::Track& track) {
+			detail::renderTrack<Channels, Features>(track, outBuffer, inNumSamples);
+		});
+
+		return bufferActivity;
+	}
+
+	/**
+		Get the activity of inTrack during the last call to renderNextSamples().
+	*/
+	Activity getTrackActivity(const uint32_t inTrack) const {
+		assert(inTrack < NumTracks);
+		return tracks[inTrack].activity;
+	}
+
+	/**
+		When enabled, renderNextSamples() leaves outBuffer untouched instead of clearing it when the rendered
+		buffer is silent. Disabled by default.
+	*/
+	void setSkipSilentOutput(const bool inSkipSilentOutput) {
+		skipSilentOutput = inSkipSilentOutput;
+	}
+
+	/**
+		Reset the envelope of inTrack and enable the track.
+	*/
+	void noteOn(const uint32_t inTrack) {
+		assert(inTrack < NumTracks);
+		detail::noteOn(tracks[inTrack]);
+	}
+
+	/**
+		Sets envelope state to release.
+	*/
+	void noteOff(const uint32_t inTrack) {
+		assert(inTrack < NumTracks);
+		detail::noteOff(tracks[inTrack]);
+	}
+
+	/**
+		Set note frequency in Hz.
+	*/
+	void setFrequency(const uint32_t inTrack, const float inFrequency) {
+		assert(inTrack < NumTracks);
+		detail::setFrequency(tracks[inTrack], inFrequency, sampleRate);
+	}
+
+	/**
+		Set wave form to any of the waveform types enabled in Features. WaveformType::Sine is always available.
+	*/
+	void setWaveformType(const uint32_t inTrack, const WaveformType inWaveformType) {
+		assert(inTrack < NumTracks);
+		detail::setWaveformType<Features>(tracks[inTrack], inWaveformType);
+	}
+
+	/**
+		Set track envelope. Does not reset the envelope if it is playing. Valid parameter ranges are between 0 and 126.
+	*/
+	void setEnvelope(const uint32_t inTrack, const uint8_t inAttack, const uint8_t inDecay, const uint8_t inSustain, const uint8_t inRelease) {
+		assert(inTrack < NumTracks);
+		detail::setEnvelope(tracks[inTrack], inAttack, inDecay, inSustain, inRelease);
+	}
+
+	/**
+		Enable pulse width modulation for the square waveform type. Modulate with a sine wave LFO with the specified frequency.
+		Valid range for inPWMDepth is 0.0f to 1.0f. Requires Feature::PWM.
+	*/
+	void enablePWM(const uint32_t inTrack, const float inFrequency, const float inPWMDepth) {
+		static_assert((Features & Feature::PWM) != 0, "PWM is not enabled for this audio chip");
+		assert(inTrack < NumTracks);
+		detail::enablePWM(tracks[inTrack], inFrequency, inPWMDepth, sampleRate);
+	}
+
+	/**
+		Disable pulse width modulation.
+	*/
+	void disablePWM(const uint32_t inTrack) {
+		assert(inTrack < NumTracks);
+		detail::disablePWM(tracks[inTrack]);
+	}
+
+	/**
+		Set the sample played by the WaveformType::Sample waveform and disable its loop. The sample plays at its own
+		sample rate when the track frequency is inBaseFrequency and is pitched relative to that otherwise.
+		Requires Feature::Sample.
+	*/
+	void setSample(const uint32_t inTrack, const std::shared_ptr<const SampleAsset>& inSample, const float inBaseFrequency) {
+		static_assert((Features & Feature::Sample) != 0, "Sample playback is not enabled for this audio chip");
+		assert(inTrack < NumTracks);
+		detail::setSample(tracks[inTrack], inSample, inBaseFrequency, sampleRate);
+	}
+
+	/**
+		Loop the sample between the frames inLoopStart and inLoopEnd, exclusive, once playback reaches inLoopEnd.
+	*/
+	void enableSampleLoop(const uint32_t inTrack, const uint32_t inLoopStart, const uint32_t inLoopEnd) {
+		assert(inTrack < NumTracks);
+		detail::enableSampleLoop(tracks[inTrack], inLoopStart, inLoopEnd);
+	}
+
+	/**
+		Disable the sample loop. The note ends when the sample has played to the end.
+	*/
+	void disableSampleLoop(const uint32_t inTrack) {
+		assert(inTrack < NumTracks);
+		detail::disableSampleLoop(tracks[inTrack]);
+	}
+
+private:
+	template<typename Function, size_t... TrackIndices>
+	void forEachTrack(Function&& inFunction, std::index_sequence<TrackIndices...>) {
+		(inFunction(std::get<TrackIndices>(tracks)), ...);
+	}
+
+	template<typename Function>
+	void forEachTrack(Function&& inFunction) {
+		forEachTrack(std::forward<Function>(inFunction), std::make_index_sequence<NumTracks>());
+	}
+
+	uint32_t sampleRate;
+	bool skipSilentOutput;
+	std::array<detail::Track, NumTracks> tracks;
+};
+
+
+} // namespace AudioChip
@@ -0,0 +1,317 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Resampler.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+namespace {
+
+
+const uint32_t maxPhases = 512;
+const uint32_t maxTaps = 1024;
+const uint32_t tapAlignment = 4;
+
+constexpr double pi = M_PI;
+
+
+struct QualitySettings {
+	uint32_t zeroCrossings;
+	double passband;
+	double kaiserBeta;
+};
+
+
+QualitySettings getQualitySettings(const AudioChip::Resampler::Quality inQuality) {
+	switch (inQuality) {
+	case AudioChip::Resampler::Quality::Low:
+		return {8, 0.80, 6.0};
+	case AudioChip::Resampler::Quality::Medium:
+		return {16, 0.90, 8.5};
+	case AudioChip::Resampler::Quality::High:
+		return {32, 0.95, 10.0};
+	default:
+		assert(false);
+		return {16, 0.90, 8.5};
+	}
+}
+
+
+uint32_t greatestCommonDivisor(uint32_t inA, uint32_t inB) {
+	while (inB != 0) {
+		const uint32_t remainder = inA % inB;
+		inA = inB;
+		inB = remainder;
+	}
+	return inA;
+}
+
+
+/**
+	Zeroth order modified Bessel function of the first kind, used by the Kaiser window.
+*/
+double besselI0(const double inX) {
+	double sum = 1.0;
+	double term = 1.0;
+	for (uint32_t k = 1; k < 50; ++k) {
+		term *= (inX / (2.0 * k)) * (inX / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12) {
+			break;
+		}
+	}
+	return sum;
+}
+
+
+float dotProduct(const float* inA, const float* inB, const uint32_t inLength) {
+	assert((inLength % tapAlignment) == 0);
+
+#if defined(__SSE__)
+	__m128 sum = _mm_setzero_ps();
+	for (uint32_t i = 0; i < inLength; i += 4) {
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(inA + i), _mm_loadu_ps(inB + i)));
+	}
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+#elif defined(__ARM_NEON)
+	float32x4_t sum = vdupq_n_f32(0.0f);
+	for (uint32_t i = 0; i < inLength; i += 4) {
+		sum = vmlaq_f32(sum, vld1q_f32(inA + i), vld1q_f32(inB + i));
+	}
+	const float32x2_t halfSum = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+	return vget_lane_f32(vpadd_f32(halfSum, halfSum), 0);
+#else
+	float sum0 = 0.0f;
+	float sum1 = 0.0f;
+	float sum2 = 0.0f;
+	float sum3 = 0.0f;
+	for (uint32_t i = 0; i < inLength; i += 4) {
+		sum0 += inA[i] * inB[i];
+		sum1 += inA[i + 1] * inB[i + 1];
+		sum2 += inA[i + 2] * inB[i + 2];
+		sum3 += inA[i + 3] * inB[i + 3];
+	}
+	return (sum0 + sum1) + (sum2 + sum3);
+#endif
+}
+
+
+} // namespace
+
+
+namespace AudioChip {
+
+
+Resampler::Resampler(const uint32_t inInputSampleRate, const uint32_t inOutputSampleRate, const uint32_t inNumChannels, const Quality inQuality, const uint32_t inMaxOutputFrames)
+	: numChannels(inNumChannels),
+	  maxOutputFrames(inMaxOutputFrames),
+	  historyCapacity(0)
+{
+	assert(inInputSampleRate > 0);
+	assert(inOutputSampleRate > 0);
+	assert(inNumChannels > 0);
+	assert(inMaxOutputFrames > 0);
+
+	// Output frames are spaced exactly clockStep / clockModulus input frames apart
+	const uint32_t divisor = greatestCommonDivisor(inInputSampleRate, inOutputSampleRate);
+	clockModulus = inOutputSampleRate / divisor;
+	clockStep = inInputSampleRate / divisor;
+
+	// Ratios that need more phases than the table holds interpolate between the two nearest phases
+	interpolatePhases = clockModulus > maxPhases;
+	numPhases = interpolatePhases ? maxPhases : clockModulus;
+
+	// When downsampling the cutoff follows the output Nyquist frequency and the filter gets longer
+	const QualitySettings settings = getQualitySettings(inQuality);
+	const double downsampleFactor = std::max(1.0, static_cast<double>(clockStep) / static_cast<double>(clockModulus));
+	numTaps = static_cast<uint32_t>(ceil(2.0 * settings.zeroCrossings * downsampleFactor));
+	numTaps = std::min(maxTaps, (numTaps + tapAlignment - 1) / tapAlignment * tapAlignment);
+
+	// Kaiser windowed sinc prototype at numPhases times the input rate, split into one filter per phase
+	const uint32_t prototypeLength = numTaps * numPhases;
+	const double center = (prototypeLength - 1) / 2.0;
+	const double cutoff = settings.passband / (2.0 * numPhases * downsampleFactor);
+	const double windowNormalization = besselI0(settings.kaiserBeta);
+
+	// Interpolation also needs the phase one input frame later, which continues the prototype past its end
+	const uint32_t numTablePhases = interpolatePhases ? numPhases + 1 : numPhases;
+
+	coefficients.resize(numTablePhases * numTaps);
+	for (uint32_t filterPhase = 0; filterPhase < numTablePhases; ++filterPhase) {
+		float* phaseCoefficients = &coefficients[filterPhase * numTaps];
+		double phaseSum = 0.0;
+
+		for (uint32_t tap = 0; tap < numTaps; ++tap) {
+			const double offset = (numTaps - 1 - tap) * static_cast<double>(numPhases) + filterPhase - center;
+			const double windowPosition = offset / center;
+			const double window = (fabs(windowPosition) > 1.0) ? 0.0 : besselI0(settings.kaiserBeta * sqrt(std::max(0.0, 1.0 - windowPosition * windowPosition))) / windowNormalization;
+			const double sincArgument = 2.0 * cutoff * offset;
+			const double sinc = (sincArgument == 0.0) ? 1.0 : sin(pi * sincArgument) / (pi * sincArgument);
+
+			phaseCoefficients[tap] = static_cast<float>(sinc * window);
+			phaseSum += phaseCoefficients[tap];
+		}
+
+		// Unity gain at DC for every phase
+		for (uint32_t tap = 0; tap < numTaps; ++tap) {
+			phaseCoefficients[tap] = static_cast<float>(phaseCoefficients[tap] / phaseSum);
+		}
+	}
+
+	// A block spans at most the input frames of its output frames rounded up, plus one for the clock left over
+	// from the previous block. The history keeps less than one window of older frames in front of them.
+	maxInputFrames = static_cast<uint32_t>((static_cast<uint64_t>(maxOutputFrames) * clockStep + clockModulus - 1) / clockModulus + 1);
+	historyCapacity = numTaps + maxInputFrames;
+	history.resize(historyCapacity * numChannels);
+	reset();
+}
+
+
+uint32_t Resampler::getMaxInputFrames() const {
+	return maxInputFrames;
+}
+
+
+uint32_t Resampler::getInputFramesNeeded(const uint32_t inNumOutputFrames) const {
+	if (inNumOutputFrames == 0) {
+		return 0;
+	}
+
+	const uint64_t lastPosition = position + (static_cast<uint64_t>(clock) + static_cast<uint64_t>(inNumOutputFrames - 1) * clockStep) / clockModulus;
+	if (lastPosition < historyLength) {
+		return 0;
+	}
+	return static_cast<uint32_t>(lastPosition + 1 - historyLength);
+}
+
+
+bool Resampler::process(const float* inBuffer, const uint32_t inNumInputFrames, float* outBuffer, const uint32_t inNumOutputFrames, const bool inInputSilent, const bool inClearSilentOutput) {
+	assert(inBuffer != nullptr || inNumInputFrames == 0);
+	assert(outBuffer != nullptr);
+	assert(inNumOutputFrames <= maxOutputFrames);
+	assert(inNumInputFrames == getInputFramesNeeded(inNumOutputFrames));
+
+	appendInput(inBuffer, inNumInputFrames);
+	if (inInputSilent) {
+		numSilentFrames = std::min(numSilentFrames + inNumInputFrames, historyLength);
+	} else {
+		numSilentFrames = 0;
+	}
+
+	// Every window lies within the silent tail of the history
+	const bool outputSilent = (historyLength - numSilentFrames) <= (position + 1 - numTaps);
+
+	if (outputSilent) {
+		if (inClearSilentOutput) {
+			memset(outBuffer, 0, inNumOutputFrames * numChannels * sizeof(float));
+		}
+
+		const uint64_t totalClock = static_cast<uint64_t>(clock) + static_cast<uint64_t>(inNumOutputFrames) * clockStep;
+		position += static_cast<uint32_t>(totalClock / clockModulus);
+		clock = static_cast<uint32_t>(totalClock % clockModulus);
+	} else {
+		for (uint32_t frame = 0; frame < inNumOutputFrames; ++frame) {
+			const uint32_t windowStart = position + 1 - numTaps;
+
+			if (interpolatePhases) {
+				const uint64_t scaledClock = static_cast<uint64_t>(clock) * numPhases;
+				const uint32_t filterPhase = static_cast<uint32_t>(scaledClock / clockModulus);
+				const float fraction = static_cast<float>(scaledClock % clockModulus) / static_cast<float>(clockModulus);
+				const float* phaseCoefficients = &coefficients[filterPhase * numTaps];
+				const float* nextPhaseCoefficients = phaseCoefficients + numTaps;
+
+				for (uint32_t channel = 0; channel < numChannels; ++channel) {
+					const float* window = &history[channel * historyCapacity + windowStart];
+					const float current = dotProduct(phaseCoefficients, window, numTaps);
+					const float next = dotProduct(nextPhaseCoefficients, window, numTaps);
+					outBuffer[frame * numChannels + channel] = current + (next - current) * fraction;
+				}
+			} else {
+				const float* phaseCoefficients = &coefficients[clock * numTaps];
+				for (uint32_t channel = 0; channel < numChannels; ++channel) {
+					outBuffer[frame * numChannels + channel] = dotProduct(phaseCoefficients, &history[channel * historyCapacity + windowStart], numTaps);
+				}
+			}
+
+			clock += clockStep;
+			position += clock / clockModulus;
+			clock %= clockModulus;
+		}
+	}
+
+	// Drop the frames that no coming window reaches
+	const uint32_t discardFrames = std::min(position + 1 - numTaps, historyLength);
+	if (discardFrames > 0) {
+		const uint32_t keptFrames = historyLength - discardFrames;
+		for (uint32_t channel = 0; channel < numChannels; ++channel) {
+			float* channelHistory = &history[channel * historyCapacity];
+			memmove(channelHistory, channelHistory + discardFrames, keptFrames * sizeof(float));
+		}
+		historyLength = keptFrames;
+		position -= discardFrames;
+		numSilentFrames = std::min(numSilentFrames, historyLength);
+	}
+
+	return outputSilent;
+}
+
+
+void Resampler::reset() {
+	std::fill(history.begin(), history.end(), 0.0f);
+
+	// Start with a silent window ending at the first input frame
+	historyLength = numTaps - 1;
+	numSilentFrames = historyLength;
+	position = numTaps - 1;
+	clock = 0;
+}
+
+
+void Resampler::appendInput(const float* inBuffer, const uint32_t inNumInputFrames) {
+	assert(historyLength + inNumInputFrames <= historyCapacity);
+
+	for (uint32_t channel = 0; channel < numChannels; ++channel) {
+		float* channelHistory = &history[channel * historyCapacity + historyLength];
+		for (uint32_t frame = 0; frame < inNumInputFrames; ++frame) {
+			channelHistory[frame] = inBuffer[frame * numChannels + channel];
+		}
+	}
+	historyLength += inNumInputFrames;
+}
+
+
+} // namespace AudioChip
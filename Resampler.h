@@ -0,0 +1,105 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace AudioChip {
+
+
+/**
+	Streaming polyphase resampler for interleaved float samples. The input clock is tracked exactly with an
+	integer accumulator for any pair of sample rates, so there is no rate or pitch error. Ratios that reduce to at
+	most 512 output frames per period, such as 22050 Hz to 48000 Hz, use one filter phase per output position.
+	Other ratios, such as 11025 Hz to 48000 Hz or arbitrary chip clocks, interpolate between the two nearest of 512
+	phases at twice the filter cost.
+*/
+class Resampler {
+public:
+	enum class Quality {Low, Medium, High};
+
+	Resampler() = delete;
+
+	/**
+		Create a resampler for blocks of at most inMaxOutputFrames output frames. All buffers are allocated here,
+		process() never allocates.
+	*/
+	Resampler(const uint32_t inInputSampleRate, const uint32_t inOutputSampleRate, const uint32_t inNumChannels, const Quality inQuality, const uint32_t inMaxOutputFrames);
+
+	/**
+		Upper bound of getInputFramesNeeded() for any block of at most the maximum number of output frames.
+	*/
+	uint32_t getMaxInputFrames() const;
+
+	/**
+		Number of input frames that process() consumes to produce inNumOutputFrames output frames.
+	*/
+	uint32_t getInputFramesNeeded(const uint32_t inNumOutputFrames) const;
+
+	/**
+		Resample inNumInputFrames frames from inBuffer, which must be getInputFramesNeeded(inNumOutputFrames), to
+		inNumOutputFrames frames in outBuffer, at most the maximum given to the constructor. Set inInputSilent if
+		inBuffer only contains zeros, the filter is then skipped once its history has run silent. Returns true if
+		the output is silent, in which case outBuffer is only cleared if inClearSilentOutput is set.
+	*/
+	bool process(const float* inBuffer, const uint32_t inNumInputFrames, float* outBuffer, const uint32_t inNumOutputFrames, const bool inInputSilent, const bool inClearSilentOutput);
+
+	/**
+		Clear the filter history.
+	*/
+	void reset();
+
+private:
+	void appendInput(const float* inBuffer, const uint32_t inNumInputFrames);
+
+	uint32_t numChannels;
+	uint32_t maxOutputFrames;
+	uint32_t maxInputFrames;
+	uint32_t numTaps;
+	uint32_t numPhases;
+	bool interpolatePhases;
+
+	// Every output frame advances clock by clockStep, each wrap at clockModulus is one input frame
+	uint32_t clockStep;
+	uint32_t clockModulus;
+
+	// Coefficients of each phase in reverse order, so that every output is a dot product with the history
+	std::vector<float> coefficients;
+
+	// Input history, one contiguous run of frames per channel
+	std::vector<float> history;
+	uint32_t historyCapacity;
+	uint32_t historyLength;
+	uint32_t numSilentFrames;
+
+	uint32_t position;
+	uint32_t clock;
+};
+
+
+} // namespace AudioChip
@@ -0,0 +1,211 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SampleAsset.h"
+
+
+namespace {
+
+
+const uint16_t wavFormatPCM = 1;
+const uint16_t wavFormatFloat = 3;
+const uint16_t wavFormatExtensible = 0xFFFE;
+
+
+size_t getBytesPerSample(const AudioChip::SampleAsset::Format inFormat) {
+	return (inFormat == AudioChip::SampleAsset::Format::Int16) ? sizeof(int16_t) : sizeof(float);
+}
+
+
+uint16_t readUint16(const uint8_t* inBytes) {
+	return static_cast<uint16_t>(inBytes[0] | (inBytes[1] << 8));
+}
+
+
+uint32_t readUint32(const uint8_t* inBytes) {
+	return static_cast<uint32_t>(inBytes[0]) | (static_cast<uint32_t>(inBytes[1]) << 8) | (static_cast<uint32_t>(inBytes[2]) << 16) | (static_cast<uint32_t>(inBytes[3]) << 24);
+}
+
+
+/**
+	Map the whole file read only. Nothing is read from the file until the mapped pages are touched.
+*/
+bool mapWholeFile(const char* inPath, void*& outMapping, size_t& outMappingSize) {
+	assert(inPath != nullptr);
+
+	const int fileDescriptor = open(inPath, O_RDONLY);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0) {
+		close(fileDescriptor);
+		return false;
+	}
+
+	const size_t mappingSize = static_cast<size_t>(fileStatus.st_size);
+	void* mapping = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	close(fileDescriptor);
+
+	if (mapping == MAP_FAILED) {
+		return false;
+	}
+
+	outMapping = mapping;
+	outMappingSize = mappingSize;
+	return true;
+}
+
+
+} // namespace
+
+
+namespace AudioChip {
+
+
+SampleAsset::SampleAsset(const void* inData, const Format inFormat, const uint32_t inNumChannels, const uint32_t inNumFrames, const uint32_t inSampleRate, void* inMapping, const size_t inMappingSize)
+	: data(inData),
+	  format(inFormat),
+	  numChannels(inNumChannels),
+	  numFrames(inNumFrames),
+	  sampleRate(inSampleRate),
+	  mapping(inMapping),
+	  mappingSize(inMappingSize)
+{
+	assert(inData != nullptr);
+	assert(inNumChannels == 1 || inNumChannels == 2);
+	assert(inNumFrames > 0);
+	assert(inSampleRate > 0);
+	assert((reinterpret_cast<uintptr_t>(inData) % getBytesPerSample(inFormat)) == 0);
+}
+
+
+SampleAsset::~SampleAsset() {
+	if (mapping != nullptr) {
+		munmap(mapping, mappingSize);
+	}
+}
+
+
+std::shared_ptr<const SampleAsset> SampleAsset::fromBuffer(const void* inData, const Format inFormat, const uint32_t inNumChannels, const uint32_t inNumFrames, const uint32_t inSampleRate) {
+	return std::shared_ptr<const SampleAsset>(new SampleAsset(inData, inFormat, inNumChannels, inNumFrames, inSampleRate, nullptr, 0));
+}
+
+
+std::shared_ptr<const SampleAsset> SampleAsset::mapFile(const char* inPath, const Format inFormat, const uint32_t inNumChannels, const uint32_t inSampleRate, const size_t inByteOffset) {
+	assert(inNumChannels == 1 || inNumChannels == 2);
+
+	void* mapping = nullptr;
+	size_t mappingSize = 0;
+	if (!mapWholeFile(inPath, mapping, mappingSize)) {
+		return nullptr;
+	}
+
+	const size_t bytesPerFrame = getBytesPerSample(inFormat) * inNumChannels;
+	const size_t numFrames = (inByteOffset < mappingSize) ? (mappingSize - inByteOffset) / bytesPerFrame : 0;
+	if (numFrames == 0 || numFrames > UINT32_MAX || (inByteOffset % getBytesPerSample(inFormat)) != 0) {
+		munmap(mapping, mappingSize);
+		return nullptr;
+	}
+
+	const uint8_t* sampleData = static_cast<const uint8_t*>(mapping) + inByteOffset;
+	return std::shared_ptr<const SampleAsset>(new SampleAsset(sampleData, inFormat, inNumChannels, static_cast<uint32_t>(numFrames), inSampleRate, mapping, mappingSize));
+}
+
+
+std::shared_ptr<const SampleAsset> SampleAsset::mapWavFile(const char* inPath) {
+	void* mapping = nullptr;
+	size_t mappingSize = 0;
+	if (!mapWholeFile(inPath, mapping, mappingSize)) {
+		return nullptr;
+	}
+
+	const uint8_t* bytes = static_cast<const uint8_t*>(mapping);
+	if (mappingSize < 12 || memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0) {
+		munmap(mapping, mappingSize);
+		return nullptr;
+	}
+
+	uint16_t audioFormat = 0;
+	uint16_t numChannels = 0;
+	uint32_t sampleRate = 0;
+	uint16_t bitsPerSample = 0;
+	size_t dataOffset = 0;
+	size_t dataSize = 0;
+
+	size_t chunkOffset = 12;
+	while (chunkOffset + 8 <= mappingSize) {
+		const uint8_t* chunk = bytes + chunkOffset;
+		const size_t chunkSize = readUint32(chunk + 4);
+		const size_t bodyOffset = chunkOffset + 8;
+
+		if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && bodyOffset + 16 <= mappingSize) {
+			audioFormat = readUint16(chunk + 8);
+			numChannels = readUint16(chunk + 10);
+			sampleRate = readUint32(chunk + 12);
+			bitsPerSample = readUint16(chunk + 22);
+			if (audioFormat == wavFormatExtensible && chunkSize >= 26 && bodyOffset + 26 <= mappingSize) {
+				audioFormat = readUint16(chunk + 32);
+			}
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			dataOffset = bodyOffset;
+			dataSize = std::min(chunkSize, mappingSize - bodyOffset);
+			break;
+		}
+
+		// Chunks are padded to an even size
+		chunkOffset = bodyOffset + chunkSize + (chunkSize & 1);
+	}
+
+	Format format;
+	if (audioFormat == wavFormatPCM && bitsPerSample == 16) {
+		format = Format::Int16;
+	} else if (audioFormat == wavFormatFloat && bitsPerSample == 32) {
+		format = Format::Float32;
+	} else {
+		munmap(mapping, mappingSize);
+		return nullptr;
+	}
+
+	const size_t bytesPerFrame = getBytesPerSample(format) * numChannels;
+	if ((numChannels != 1 && numChannels != 2) || sampleRate == 0 || dataSize < bytesPerFrame || dataSize / bytesPerFrame > UINT32_MAX || (dataOffset % getBytesPerSample(format)) != 0) {
+		munmap(mapping, mappingSize);
+		return nullptr;
+	}
+
+	return std::shared_ptr<const SampleAsset>(new SampleAsset(bytes + dataOffset, format, numChannels, static_cast<uint32_t>(dataSize / bytesPerFrame), sampleRate, mapping, mappingSize));
+}
+
+
+} // namespace AudioChip
@@ -0,0 +1,86 @@
+/*
+The MIT License (MIT)
+
+Copyright (c) 2015 Marcus Spangenberg
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace AudioChip {
+
+
+/**
+	Interleaved mono or stereo PCM data played by WaveformType::Sample tracks. The samples are read in place
+	from caller owned memory or a memory mapped file, and one asset can be shared by any number of tracks and
+	chips. Pages of a mapped file are only loaded when they are played.
+*/
+class SampleAsset {
+public:
+	enum class Format {Int16, Float32};
+
+	SampleAsset(const SampleAsset&) = delete;
+	SampleAsset& operator=(const SampleAsset&) = delete;
+	~SampleAsset();
+
+	/**
+		Wrap caller owned interleaved PCM data without copying it. inData must outlive the asset.
+	*/
+	static std::shared_ptr<const SampleAsset> fromBuffer(const void* inData, const Format inFormat, const uint32_t inNumChannels, const uint32_t inNumFrames, const uint32_t inSampleRate);
+
+	/**
+		Memory map raw interleaved PCM data starting at inByteOffset in the file inPath. Returns nullptr if the
+		file cannot be mapped.
+	*/
+	static std::shared_ptr<const SampleAsset> mapFile(const char* inPath, const Format inFormat, const uint32_t inNumChannels, const uint32_t inSampleRate, const size_t inByteOffset = 0);
+
+	/**
+		Memory map a WAV file with 16 bit integer or 32 bit float samples. Returns nullptr if the file cannot be
+		mapped or is not a supported WAV file.
+	*/
+	static std::shared_ptr<const SampleAsset> mapWavFile(const char* inPath);
+
+	Format getFormat() const { return format; }
+	uint32_t getNumChannels() const { return numChannels; }
+	uint32_t getNumFrames() const { return numFrames; }
+	uint32_t getSampleRate() const { return sampleRate; }
+	const void* getData() const { return data; }
+
+private:
+	SampleAsset(const void* inData, const Format inFormat, const uint32_t inNumChannels, const uint32_t inNumFrames, const uint32_t inSampleRate, void* inMapping, const size_t inMappingSize);
+
+	const void* data;
+	Format format;
+	uint32_t numChannels;
+	uint32_t numFrames;
+	uint32_t sampleRate;
+
+	void* mapping;
+	size_t mappingSize;
+};
+
+
+} // namespace AudioChip
@@ -42,7 +42,7 @@ public:
 
 	inline float lookupSinf(const float inPhase) {
 		const uint32_t step = static_cast<uint32_t>((inPhase / pi2) * static_cast<float>(size)) & mask;
-		const uint32_t step2 = step + 1;
+		const uint32_t step2 = (step + 1) & mask;
 		return (data[step] + data[step2]) / 2.0f;
 	}
 
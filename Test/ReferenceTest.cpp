@@ -0,0 +1,1069 @@
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+#include "../AudioChip.h"
+#include "../BasicAudioChip.h"
+#include "../Resampler.h"
+#include "../SampleAsset.h"
+
+
+namespace {
+
+
+const uint32_t sampleRate = 44100;
+const uint32_t bufferSize = 256;
+const uint32_t numChannels = 2;
+const uint32_t fftSize = 8192;
+
+constexpr double pi = M_PI;
+constexpr double pi2 = M_PI * 2.0;
+constexpr double envelopeMaxParameterValue = 126.0;
+constexpr double envelopeFactorPerStep = 1.0 / (envelopeMaxParameterValue + 1.0);
+constexpr double envelopeTimePerStep = 10000.0 / (envelopeMaxParameterValue + 1.0);
+
+
+typedef std::vector<double> Signal;
+
+
+struct Patch {
+	const char* name;
+	AudioChip::WaveformType waveformType;
+	float frequency;
+	uint8_t attack;
+	uint8_t decay;
+	uint8_t sustain;
+	uint8_t release;
+	float pwmFrequency;
+	float pwmDepth;
+	uint32_t noteOffBuffer;
+	uint32_t numBuffers;
+	double minSNR;
+};
+
+
+/**
+	Canonical patches. The short notes keep the single precision phase accumulators of the chip close enough to
+	the reference that the comparison measures the generators and not the accumulated phase drift.
+*/
+const Patch patches[] = {
+	{"sine A4", AudioChip::WaveformType::Sine, 440.0f, 0, 0, 126, 0, 0.0f, 0.0f, 40, 48, 60.0},
+	{"square 110 Hz", AudioChip::WaveformType::Square, 110.0f, 2, 10, 90, 3, 0.0f, 0.0f, 40, 60, 50.0},
+	{"square 1760 Hz", AudioChip::WaveformType::Square, 1760.0f, 0, 0, 126, 0, 0.0f, 0.0f, 40, 48, 55.0},
+	{"square 100 Hz PWM", AudioChip::WaveformType::Square, 100.0f, 5, 5, 100, 5, 0.2f, 0.9f, 40, 60, 36.0},
+	{"saw 220 Hz", AudioChip::WaveformType::Saw, 220.0f, 1, 20, 60, 9, 0.0f, 0.0f, 40, 60, 44.0},
+	{"saw 3520 Hz", AudioChip::WaveformType::Saw, 3520.0f, 0, 0, 126, 0, 0.0f, 0.0f, 40, 48, 55.0},
+};
+
+
+/**
+	Quality thresholds per rendering path, all in dB. Every measured value is printed so that a faster kernel
+	can move a threshold with numbers to back it up. The full chip is checked against the minSNR of each patch.
+*/
+struct GeneratorThresholds {
+	double minSNR;
+	double maxTHDN;
+	double maxAliasing;
+};
+
+const double minSineTableSNR = 60.0;
+const GeneratorThresholds generatorThresholds = {60.0, -70.0, -55.0};
+const double maxChipTHDN = -60.0;
+
+/**
+	A skipped track advances its phase in one step per buffer instead of once per sample, so the single precision
+	rounding differs. The margin still catches an offset of one sample, which costs a 440 Hz tone about 24 dB.
+*/
+const double minSkippedPhaseSNR = 40.0;
+
+/**
+	Resampler thresholds per quality: THD+N of a resampled tone and the level of a tone above the output Nyquist
+	frequency that must be filtered out when downsampling.
+*/
+struct ResamplerThresholds {
+	const char* name;
+	AudioChip::Resampler::Quality quality;
+	double maxTHDN;
+	double maxRejectedLevel;
+};
+
+const ResamplerThresholds resamplerThresholds[] = {
+	{"low", AudioChip::Resampler::Quality::Low, -60.0, -65.0},
+	{"medium", AudioChip::Resampler::Quality::Medium, -85.0, -90.0},
+	{"high", AudioChip::Resampler::Quality::High, -105.0, -105.0},
+};
+const double maxResampledPitchErrorCents = 0.01;
+const double minSampleSNR = 50.0;
+const double maxEnvelopeTimingErrorMs = 1000.0 * bufferSize / sampleRate + 0.5;
+
+
+uint32_t numFailures = 0;
+
+
+void report(const char* inPath, const char* inName, const char* inMetric, const double inValue, const double inLimit, const bool inPassed) {
+	printf("%s %-16s %-20s %-12s %9.2f (limit %7.2f)\n", inPassed ? "PASS" : "FAIL", inPath, inName, inMetric, inValue, inLimit);
+	if (!inPassed) {
+		++numFailures;
+	}
+}
+
+
+void expectAtLeast(const char* inPath, const char* inName, const char* inMetric, const double inValue, const double inLimit) {
+	report(inPath, inName, inMetric, inValue, inLimit, inValue >= inLimit);
+}
+
+
+void expectAtMost(const char* inPath, const char* inName, const char* inMetric, const double inValue, const double inLimit) {
+	report(inPath, inName, inMetric, inValue, inLimit, inValue <= inLimit);
+}
+
+
+/*
+	Metrics
+*/
+
+double powerToDb(const double inPower) {
+	return 10.0 * log10(std::max(inPower, 1e-30));
+}
+
+
+double calcSNR(const Signal& inReference, const Signal& inSignal) {
+	assert(inReference.size() == inSignal.size());
+
+	double signalPower = 0.0;
+	double noisePower = 0.0;
+	for (size_t i = 0; i < inReference.size(); ++i) {
+		const double error = inSignal[i] - inReference[i];
+		signalPower += inReference[i] * inReference[i];
+		noisePower += error * error;
+	}
+	return powerToDb(signalPower) - powerToDb(noisePower);
+}
+
+
+/**
+	Power of everything except the fundamental relative to the total power. The fundamental is removed by a
+	least squares fit of a sine and a cosine at inFrequency.
+*/
+double calcTHDN(const Signal& inSignal, const double inFrequency, const uint32_t inSampleRate) {
+	const double phaseIncrement = pi2 * inFrequency / inSampleRate;
+
+	double ss = 0.0, sc = 0.0, cc = 0.0, xs = 0.0, xc = 0.0;
+	for (size_t i = 0; i < inSignal.size(); ++i) {
+		const double s = sin(phaseIncrement * i);
+		const double c = cos(phaseIncrement * i);
+		ss += s * s;
+		sc += s * c;
+		cc += c * c;
+		xs += inSignal[i] * s;
+		xc += inSignal[i] * c;
+	}
+
+	const double determinant = ss * cc - sc * sc;
+	const double a = (xs * cc - xc * sc) / determinant;
+	const double b = (xc * ss - xs * sc) / determinant;
+
+	double totalPower = 0.0;
+	double residualPower = 0.0;
+	for (size_t i = 0; i < inSignal.size(); ++i) {
+		const double residual = inSignal[i] - a * sin(phaseIncrement * i) - b * cos(phaseIncrement * i);
+		totalPower += inSignal[i] * inSignal[i];
+		residualPower += residual * residual;
+	}
+	return powerToDb(residualPower) - powerToDb(totalPower);
+}
+
+
+void fft(std::vector<std::complex<double>>& ioData) {
+	const size_t size = ioData.size();
+	assert((size & (size - 1)) == 0);
+
+	for (size_t i = 1, j = 0; i < size; ++i) {
+		size_t bit = size >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			std::swap(ioData[i], ioData[j]);
+		}
+	}
+
+	for (size_t length = 2; length <= size; length <<= 1) {
+		const std::complex<double> rotation = std::polar(1.0, -pi2 / length);
+		for (size_t start = 0; start < size; start += length) {
+			std::complex<double> twiddle = 1.0;
+			for (size_t k = 0; k < length / 2; ++k) {
+				const std::complex<double> even = ioData[start + k];
+				const std::complex<double> odd = ioData[start + k + length / 2] * twiddle;
+				ioData[start + k] = even + odd;
+				ioData[start + k + length / 2] = even - odd;
+				twiddle *= rotation;
+			}
+		}
+	}
+}
+
+
+/**
+	Power in bins that are not harmonics of the fundamental relative to the total power. inSignal must hold
+	fftSize samples of a tone whose period divides fftSize into inFundamentalBin periods, so that harmonics and
+	anything folded back from above Nyquist land in separate bins without windowing.
+*/
+double calcAliasing(const Signal& inSignal, const uint32_t inFundamentalBin) {
+	assert(inSignal.size() == fftSize);
+
+	std::vector<std::complex<double>> spectrum(inSignal.begin(), inSignal.end());
+	fft(spectrum);
+
+	double totalPower = 0.0;
+	double aliasedPower = 0.0;
+	for (uint32_t bin = 1; bin < fftSize / 2; ++bin) {
+		const double power = std::norm(spectrum[bin]);
+		totalPower += power;
+		if (bin % inFundamentalBin != 0) {
+			aliasedPower += power;
+		}
+	}
+	return powerToDb(aliasedPower) - powerToDb(totalPower);
+}
+
+
+/*
+	Double precision reference of the additive model
+*/
+
+uint32_t referenceHighestSubharmonic(const double inFrequency) {
+	uint32_t highestSubharmonic = 0;
+	while (inFrequency * (highestSubharmonic + 1) < sampleRate / 2.0) {
+		++highestSubharmonic;
+	}
+	return highestSubharmonic;
+}
+
+
+double referenceSaw(const double inPhase, const uint32_t inHighestSubharmonic) {
+	double outSample = 0.0;
+	for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; ++freqMultiplier) {
+		outSample += sin(inPhase * freqMultiplier) / freqMultiplier;
+	}
+	return outSample;
+}
+
+
+double referenceSquare(const double inPhase, const uint32_t inHighestSubharmonic, const double inPWMPhaseOffset) {
+	if (inPWMPhaseOffset == 0.0) {
+		double outSample = 0.0;
+		for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; freqMultiplier += 2) {
+			outSample += sin(inPhase * freqMultiplier) / freqMultiplier;
+		}
+		return outSample;
+	}
+
+	// Difference between a saw and a saw with alternating harmonic signs at the offset phase
+	const double offsetPhase = inPhase + inPWMPhaseOffset;
+	double invertedSaw = 0.0;
+	for (uint32_t freqMultiplier = 1; freqMultiplier <= inHighestSubharmonic; ++freqMultiplier) {
+		const double sign = (freqMultiplier & 1) ? -1.0 : 1.0;
+		invertedSaw += sign * sin(offsetPhase * freqMultiplier) / freqMultiplier;
+	}
+	return referenceSaw(inPhase, inHighestSubharmonic) - invertedSaw;
+}
+
+
+double referenceGenerator(const AudioChip::WaveformType inWaveformType, const double inPhase, const uint32_t inHighestSubharmonic, const double inPWMPhaseOffset) {
+	switch (inWaveformType) {
+	case AudioChip::WaveformType::Sine:
+		return sin(inPhase);
+	case AudioChip::WaveformType::Square:
+		return referenceSquare(inPhase, inHighestSubharmonic, inPWMPhaseOffset);
+	case AudioChip::WaveformType::Saw:
+		return referenceSaw(inPhase, inHighestSubharmonic);
+	default:
+		assert(false);
+		return 0.0;
+	}
+}
+
+
+struct ReferenceEnvelope {
+	enum class State {Attack, Decay, Sustain, Release};
+
+	/**
+		Same block wise envelope as the chip. Returns true when the note has ended.
+	*/
+	bool advance(const Patch& inPatch, const uint32_t inNumSamples) {
+		const double elapsedTimeMs = 1000.0 * inNumSamples / sampleRate;
+
+		switch (state) {
+		case State::Attack:
+			factor += elapsedTimeMs / (inPatch.attack == 0 ? 1.0 : envelopeTimePerStep * inPatch.attack);
+			if (factor >= 1.0) {
+				factor = 1.0;
+				state = State::Decay;
+			}
+			break;
+		case State::Decay:
+			factor -= elapsedTimeMs / (inPatch.decay == 0 ? 1.0 : envelopeTimePerStep * inPatch.decay);
+			if (factor <= inPatch.sustain * envelopeFactorPerStep) {
+				factor = inPatch.sustain * envelopeFactorPerStep;
+				state = State::Sustain;
+			}
+			break;
+		case State::Sustain:
+			factor = (inPatch.sustain == envelopeMaxParameterValue) ? 1.0 : inPatch.sustain * envelopeFactorPerStep;
+			break;
+		case State::Release:
+			if (inPatch.release == 0) {
+				factor = 0.0;
+				return true;
+			}
+			factor -= elapsedTimeMs / (envelopeTimePerStep * inPatch.release);
+			if (factor <= 0.0) {
+				factor = 0.0;
+				return true;
+			}
+			break;
+		}
+		return false;
+	}
+
+	State state = State::Attack;
+	double factor = 0.0;
+};
+
+
+Signal renderReference(const Patch& inPatch) {
+	Signal outSignal(inPatch.numBuffers * bufferSize, 0.0);
+
+	const double phaseIncrement = pi2 * inPatch.frequency / sampleRate;
+	const double pwmPhaseIncrement = pi2 * inPatch.pwmFrequency / sampleRate;
+	const uint32_t highestSubharmonic = referenceHighestSubharmonic(inPatch.frequency);
+
+	ReferenceEnvelope envelope;
+	double phase = 0.0;
+	double pwmPhase = 0.0;
+
+	for (uint32_t buffer = 0; buffer < inPatch.numBuffers; ++buffer) {
+		if (buffer == inPatch.noteOffBuffer) {
+			envelope.state = ReferenceEnvelope::State::Release;
+		}
+		if (envelope.advance(inPatch, bufferSize)) {
+			break;
+		}
+
+		for (uint32_t sample = 0; sample < bufferSize; ++sample) {
+			double pwmPhaseOffset = 0.0;
+			if (inPatch.pwmDepth != 0.0f) {
+				pwmPhaseOffset = sin(pwmPhase) * inPatch.pwmDepth * pi;
+				pwmPhase = fmod(pwmPhase + pwmPhaseIncrement, pi2);
+			}
+
+			outSignal[buffer * bufferSize + sample] = referenceGenerator(inPatch.waveformType, phase, highestSubharmonic, pwmPhaseOffset) * envelope.factor;
+			phase = fmod(phase + phaseIncrement, pi2);
+		}
+	}
+
+	return outSignal;
+}
+
+
+/*
+	Optimized paths
+*/
+
+template<typename Chip>
+Signal renderChip(Chip& ioChip, const Patch& inPatch) {
+	Signal outSignal;
+	outSignal.reserve(inPatch.numBuffers * bufferSize);
+
+	ioChip.setWaveformType(0, inPatch.waveformType);
+	ioChip.setFrequency(0, inPatch.frequency);
+	ioChip.setEnvelope(0, inPatch.attack, inPatch.decay, inPatch.sustain, inPatch.release);
+	if (inPatch.pwmDepth != 0.0f) {
+		ioChip.enablePWM(0, inPatch.pwmFrequency, inPatch.pwmDepth);
+	}
+	ioChip.noteOn(0);
+
+	float buffer[bufferSize * numChannels];
+	for (uint32_t bufferNum = 0; bufferNum < inPatch.numBuffers; ++bufferNum) {
+		if (bufferNum == inPatch.noteOffBuffer) {
+			ioChip.noteOff(0);
+		}
+		ioChip.renderNextSamples(buffer, bufferSize);
+		for (uint32_t sample = 0; sample < bufferSize; ++sample) {
+			outSignal.push_back(buffer[sample * numChannels]);
+		}
+	}
+
+	return outSignal;
+}
+
+
+Signal renderGenerator(const AudioChip::WaveformType inWaveformType, const float inFrequency, const uint32_t inNumSamples, const bool inReference) {
+	Signal outSignal(inNumSamples);
+
+	const float phaseIncrement = AudioChip::detail::frequencyToPhaseIncrement(inFrequency, sampleRate);
+	const uint32_t highestSubharmonic = AudioChip::detail::calcHighestSubharmonic(inFrequency, sampleRate);
+	assert(highestSubharmonic == referenceHighestSubharmonic(inFrequency));
+
+	// Both paths get the same phases so that only the generators are compared
+	float phase = 0.0f;
+	for (uint32_t sample = 0; sample < inNumSamples; ++sample) {
+		if (inReference) {
+			outSignal[sample] = referenceGenerator(inWaveformType, phase, highestSubharmonic, 0.0);
+		} else {
+			switch (inWaveformType) {
+			case AudioChip::WaveformType::Sine:
+				outSignal[sample] = AudioChip::detail::sineGenerator(phase, highestSubharmonic, 0.0f);
+				break;
+			case AudioChip::WaveformType::Square:
+				outSignal[sample] = AudioChip::detail::squareGenerator(phase, highestSubharmonic, 0.0f);
+				break;
+			case AudioChip::WaveformType::Saw:
+				outSignal[sample] = AudioChip::detail::sawGenerator(phase, highestSubharmonic, 0.0f);
+				break;
+			default:
+				assert(false);
+			}
+		}
+
+		phase += phaseIncrement;
+		if (phase >= static_cast<float>(pi2)) {
+			phase -= static_cast<float>(pi2);
+		}
+	}
+
+	return outSignal;
+}
+
+
+/*
+	Tests
+*/
+
+void testSineTable() {
+	// Generators look up multiples of the phase, so cover several periods
+	const uint32_t numPhases = 100000;
+	const double maxPhase = pi2 * 64.0;
+
+	Signal reference(numPhases);
+	Signal table(numPhases);
+	for (uint32_t i = 0; i < numPhases; ++i) {
+		const float phase = static_cast<float>(maxPhase * i / numPhases);
+		reference[i] = sin(static_cast<double>(phase));
+		table[i] = AudioChip::detail::sineTable.lookupSinf(phase);
+	}
+
+	expectAtLeast("lookupSinf", "phase sweep", "SNR dB", calcSNR(reference, table), minSineTableSNR);
+}
+
+
+void testGenerators() {
+	struct GeneratorCase {
+		const char* name;
+		AudioChip::WaveformType waveformType;
+		uint32_t fundamentalBin;
+	};
+
+	// Frequencies are whole bins of the FFT so that the aliasing measurement needs no window
+	const GeneratorCase generatorCases[] = {
+		{"sine bin 82", AudioChip::WaveformType::Sine, 82},
+		{"square bin 21", AudioChip::WaveformType::Square, 21},
+		{"square bin 328", AudioChip::WaveformType::Square, 328},
+		{"saw bin 41", AudioChip::WaveformType::Saw, 41},
+		{"saw bin 655", AudioChip::WaveformType::Saw, 655},
+	};
+
+	for (const GeneratorCase& generatorCase : generatorCases) {
+		const float frequency = static_cast<float>(static_cast<double>(sampleRate) * generatorCase.fundamentalBin / fftSize);
+		const Signal reference = renderGenerator(generatorCase.waveformType, frequency, fftSize, true);
+		const Signal generated = renderGenerator(generatorCase.waveformType, frequency, fftSize, false);
+
+		expectAtLeast("generator", generatorCase.name, "SNR dB", calcSNR(reference, generated), generatorThresholds.minSNR);
+		expectAtMost("generator", generatorCase.name, "aliasing dB", calcAliasing(generated, generatorCase.fundamentalBin), generatorThresholds.maxAliasing);
+		if (generatorCase.waveformType == AudioChip::WaveformType::Sine) {
+			expectAtMost("generator", generatorCase.name, "THD+N dB", calcTHDN(generated, frequency, sampleRate), generatorThresholds.maxTHDN);
+		}
+	}
+}
+
+
+template<typename Chip>
+void testChip(const char* inPath, Chip& ioChip, const Patch& inPatch) {
+	const Signal reference = renderReference(inPatch);
+	const Signal rendered = renderChip(ioChip, inPatch);
+
+	expectAtLeast(inPath, inPatch.name, "SNR dB", calcSNR(reference, rendered), inPatch.minSNR);
+
+	if (inPatch.waveformType == AudioChip::WaveformType::Sine) {
+		// Steady state part of the note, between the attack and the note off
+		const Signal sustained(rendered.begin() + 8 * bufferSize, rendered.begin() + inPatch.noteOffBuffer * bufferSize);
+		expectAtMost(inPath, inPatch.name, "THD+N dB", calcTHDN(sustained, inPatch.frequency, sampleRate), maxChipTHDN);
+	}
+}
+
+
+void testChips() {
+	for (const Patch& patch : patches) {
+		AudioChip::AudioChip audioChip(sampleRate, 1);
+		testChip("AudioChip", audioChip, patch);
+
+		AudioChip::BasicAudioChip<1> basicAudioChip(sampleRate);
+		testChip("BasicAudioChip", basicAudioChip, patch);
+	}
+}
+
+
+void expectActivity(const char* inPath, const char* inName, const AudioChip::Activity inActivity, const AudioChip::Activity inExpected) {
+	report(inPath, inName, "activity", static_cast<double>(inActivity), static_cast<double>(inExpected), inActivity == inExpected);
+}
+
+
+/**
+	Set up one track per activity case: disabled, sustained at zero level, square and saw above the Nyquist
+	frequency, sine at the sample rate and a plain sine. ioChip needs at least six tracks.
+*/
+template<typename Chip>
+void testTrackActivity(const char* inPath, Chip& ioChip) {
+	struct ActivityCase {
+		const char* name;
+		AudioChip::WaveformType waveformType;
+		float frequency;
+		uint8_t sustain;
+		bool noteOn;
+		AudioChip::Activity expected;
+	};
+
+	const ActivityCase activityCases[] = {
+		{"disabled", AudioChip::WaveformType::Sine, 440.0f, 126, false, AudioChip::Activity::Silent},
+		{"sustain 0", AudioChip::WaveformType::Sine, 440.0f, 0, true, AudioChip::Activity::Silent},
+		{"square 30 kHz", AudioChip::WaveformType::Square, 30000.0f, 126, true, AudioChip::Activity::Silent},
+		{"saw 30 kHz", AudioChip::WaveformType::Saw, 30000.0f, 126, true, AudioChip::Activity::Silent},
+		{"sine 44.1 kHz", AudioChip::WaveformType::Sine, static_cast<float>(sampleRate), 126, true, AudioChip::Activity::Constant},
+		{"sine A4", AudioChip::WaveformType::Sine, 440.0f, 126, true, AudioChip::Activity::Active},
+	};
+
+	uint32_t track = 0;
+	for (const ActivityCase& activityCase : activityCases) {
+		ioChip.setWaveformType(track, activityCase.waveformType);
+		ioChip.setFrequency(track, activityCase.frequency);
+		ioChip.setEnvelope(track, 0, 0, activityCase.sustain, 0);
+		if (activityCase.noteOn) {
+			ioChip.noteOn(track);
+		}
+		++track;
+	}
+
+	// Attack and decay take one buffer each at zero stage time
+	float buffer[bufferSize * numChannels];
+	for (uint32_t bufferNum = 0; bufferNum < 4; ++bufferNum) {
+		ioChip.renderNextSamples(buffer, bufferSize);
+	}
+
+	track = 0;
+	for (const ActivityCase& activityCase : activityCases) {
+		expectActivity(inPath, activityCase.name, ioChip.getTrackActivity(track), activityCase.expected);
+		++track;
+	}
+}
+
+
+/**
+	A buffer of a chip without active tracks must be left untouched in skip mode, and a buffer of a chip with
+	only a constant track must hold a single value.
+*/
+template<typename Chip>
+void testSkipSilentOutput(const char* inPath, Chip& ioSilentChip, Chip& ioConstantChip) {
+	const float sentinel = 123.0f;
+	float buffer[bufferSize * numChannels];
+
+	ioSilentChip.setSkipSilentOutput(true);
+	ioSilentChip.setEnvelope(0, 0, 0, 0, 0);
+	ioSilentChip.noteOn(0);
+	uint32_t numOverwritten = 0;
+	AudioChip::Activity activity = AudioChip::Activity::Silent;
+	for (uint32_t bufferNum = 0; bufferNum < 4; ++bufferNum) {
+		std::fill(buffer, buffer + bufferSize * numChannels, sentinel);
+		activity = ioSilentChip.renderNextSamples(buffer, bufferSize);
+		// The attack raises the level in the first buffer
+		if (bufferNum != 0) {
+			numOverwritten += static_cast<uint32_t>(std::count_if(buffer, buffer + bufferSize * numChannels, [sentinel](const float inSample) { return inSample != sentinel; }));
+		}
+	}
+	expectActivity(inPath, "skip silent", activity, AudioChip::Activity::Silent);
+	expectAtMost(inPath, "skip silent", "overwritten", numOverwritten, 0.0);
+
+	ioConstantChip.setFrequency(0, static_cast<float>(sampleRate));
+	ioConstantChip.setEnvelope(0, 0, 0, 126, 0);
+	ioConstantChip.noteOn(0);
+	for (uint32_t bufferNum = 0; bufferNum < 4; ++bufferNum) {
+		activity = ioConstantChip.renderNextSamples(buffer, bufferSize);
+	}
+	const uint32_t numDifferent = static_cast<uint32_t>(std::count_if(buffer, buffer + bufferSize * numChannels, [&buffer](const float inSample) { return inSample != buffer[0]; }));
+	expectActivity(inPath, "constant", activity, AudioChip::Activity::Constant);
+	expectAtMost(inPath, "constant", "different", numDifferent, 0.0);
+}
+
+
+/**
+	Render the same note on two chips, one at zero sustain level so that its track is skipped and one at full
+	level, then raise the level of the skipped one. Both must continue from the same phase.
+*/
+template<typename Chip>
+void testSkippedPhase(const char* inPath, Chip& ioSkippedChip, Chip& ioRenderedChip) {
+	const float frequency = 440.3f;
+	const uint32_t numSkippedBuffers = 40;
+	const uint32_t numComparedBuffers = 8;
+
+	ioSkippedChip.setFrequency(0, frequency);
+	ioSkippedChip.setEnvelope(0, 0, 0, 0, 0);
+	ioSkippedChip.noteOn(0);
+	ioRenderedChip.setFrequency(0, frequency);
+	ioRenderedChip.setEnvelope(0, 0, 0, 126, 0);
+	ioRenderedChip.noteOn(0);
+
+	float skippedBuffer[bufferSize * numChannels];
+	float renderedBuffer[bufferSize * numChannels];
+	for (uint32_t bufferNum = 0; bufferNum < numSkippedBuffers; ++bufferNum) {
+		ioSkippedChip.renderNextSamples(skippedBuffer, bufferSize);
+		ioRenderedChip.renderNextSamples(renderedBuffer, bufferSize);
+	}
+	expectActivity(inPath, "skipped phase", ioSkippedChip.getTrackActivity(0), AudioChip::Activity::Silent);
+
+	ioSkippedChip.setEnvelope(0, 0, 0, 126, 0);
+	Signal skipped;
+	Signal rendered;
+	for (uint32_t bufferNum = 0; bufferNum < numComparedBuffers; ++bufferNum) {
+		ioSkippedChip.renderNextSamples(skippedBuffer, bufferSize);
+		ioRenderedChip.renderNextSamples(renderedBuffer, bufferSize);
+		for (uint32_t frame = 0; frame < bufferSize; ++frame) {
+			skipped.push_back(skippedBuffer[frame * numChannels]);
+			rendered.push_back(renderedBuffer[frame * numChannels]);
+		}
+	}
+	expectAtLeast(inPath, "skipped phase", "SNR dB", calcSNR(rendered, skipped), minSkippedPhaseSNR);
+}
+
+
+void testActivity() {
+	AudioChip::AudioChip audioChip(sampleRate, 6);
+	testTrackActivity("AudioChip", audioChip);
+	AudioChip::BasicAudioChip<6> basicAudioChip(sampleRate);
+	testTrackActivity("BasicAudioChip", basicAudioChip);
+
+	AudioChip::AudioChip silentAudioChip(sampleRate, 1);
+	AudioChip::AudioChip constantAudioChip(sampleRate, 1);
+	testSkipSilentOutput("AudioChip", silentAudioChip, constantAudioChip);
+	AudioChip::BasicAudioChip<1> silentBasicAudioChip(sampleRate);
+	AudioChip::BasicAudioChip<1> constantBasicAudioChip(sampleRate);
+	testSkipSilentOutput("BasicAudioChip", silentBasicAudioChip, constantBasicAudioChip);
+
+	AudioChip::AudioChip skippedAudioChip(sampleRate, 1);
+	AudioChip::AudioChip renderedAudioChip(sampleRate, 1);
+	testSkippedPhase("AudioChip", skippedAudioChip, renderedAudioChip);
+	AudioChip::BasicAudioChip<1> skippedBasicAudioChip(sampleRate);
+	AudioChip::BasicAudioChip<1> renderedBasicAudioChip(sampleRate);
+	testSkippedPhase("BasicAudioChip", skippedBasicAudioChip, renderedBasicAudioChip);
+}
+
+
+Signal resampleSine(AudioChip::Resampler& ioResampler, const uint32_t inInputSampleRate, const double inFrequency, const uint32_t inNumBuffers) {
+	Signal outSignal;
+	std::vector<float> input;
+	float output[bufferSize * numChannels];
+	double phase = 0.0;
+
+	for (uint32_t bufferNum = 0; bufferNum < inNumBuffers; ++bufferNum) {
+		const uint32_t numInputFrames = ioResampler.getInputFramesNeeded(bufferSize);
+		input.resize(numInputFrames * numChannels);
+		for (uint32_t frame = 0; frame < numInputFrames; ++frame) {
+			const float sample = static_cast<float>(sin(phase));
+			for (uint32_t channel = 0; channel < numChannels; ++channel) {
+				input[frame * numChannels + channel] = sample;
+			}
+			phase = fmod(phase + pi2 * inFrequency / inInputSampleRate, pi2);
+		}
+
+		ioResampler.process(input.data(), numInputFrames, output, bufferSize, false, true);
+		for (uint32_t frame = 0; frame < bufferSize; ++frame) {
+			outSignal.push_back(output[frame * numChannels]);
+		}
+	}
+
+	// Skip the filter delay
+	return Signal(outSignal.begin() + inNumBuffers / 4 * bufferSize, outSignal.end());
+}
+
+
+/**
+	Frequency of a tone from the first and last rising zero crossing, with the crossing times interpolated
+	linearly between samples.
+*/
+double measureFrequency(const Signal& inSignal, const uint32_t inSampleRate) {
+	double firstCrossing = -1.0;
+	double lastCrossing = -1.0;
+	uint32_t numPeriods = 0;
+
+	for (size_t i = 1; i < inSignal.size(); ++i) {
+		if (inSignal[i - 1] < 0.0 && inSignal[i] >= 0.0) {
+			const double crossing = (i - 1) + inSignal[i - 1] / (inSignal[i - 1] - inSignal[i]);
+			if (firstCrossing < 0.0) {
+				firstCrossing = crossing;
+			} else {
+				++numPeriods;
+			}
+			lastCrossing = crossing;
+		}
+	}
+
+	if (numPeriods == 0) {
+		return 0.0;
+	}
+	return numPeriods * inSampleRate / (lastCrossing - firstCrossing);
+}
+
+
+double calcPitchErrorCents(const double inMeasuredFrequency, const double inExpectedFrequency) {
+	return fabs(1200.0 * log2(inMeasuredFrequency / inExpectedFrequency));
+}
+
+
+void testResampler() {
+	for (const ResamplerThresholds& thresholds : resamplerThresholds) {
+		AudioChip::Resampler upsampler(22050, 48000, numChannels, thresholds.quality, bufferSize);
+		const Signal upsampled = resampleSine(upsampler, 22050, 1000.0, 200);
+		expectAtMost("Resampler", thresholds.name, "THD+N dB", calcTHDN(upsampled, 1000.0, 48000), thresholds.maxTHDN);
+
+		// A tone above the Nyquist frequency of the output must not fold back into the output
+		AudioChip::Resampler downsampler(44100, 22050, numChannels, thresholds.quality, bufferSize);
+		const Signal downsampled = resampleSine(downsampler, 44100, 15000.0, 200);
+		double power = 0.0;
+		for (const double sample : downsampled) {
+			power += sample * sample;
+		}
+		expectAtMost("Resampler", thresholds.name, "rejected dB", powerToDb(2.0 * power / downsampled.size()), thresholds.maxRejectedLevel);
+	}
+
+	// Ratios that need more phases than the filter table holds must keep the input clock exact and the quality
+	// of the phase table
+	const uint32_t inexactInputSampleRates[] = {11025, 22051, 1789773 / 40};
+	for (const uint32_t inputSampleRate : inexactInputSampleRates) {
+		char name[32];
+		snprintf(name, sizeof(name), "%u to 48000", inputSampleRate);
+
+		AudioChip::Resampler resampler(inputSampleRate, 48000, numChannels, AudioChip::Resampler::Quality::Medium, bufferSize);
+		const Signal resampled = resampleSine(resampler, inputSampleRate, 440.0, 1000);
+		expectAtMost("Resampler", name, "pitch cents", calcPitchErrorCents(measureFrequency(resampled, 48000), 440.0), maxResampledPitchErrorCents);
+		expectAtMost("Resampler", name, "THD+N dB", calcTHDN(resampled, 440.0, 48000), resamplerThresholds[1].maxTHDN);
+	}
+
+	{
+		AudioChip::AudioChip audioChip(48000, 1, 11025, AudioChip::Resampler::Quality::High, bufferSize);
+		audioChip.noteOn(0);
+
+		float buffer[bufferSize * numChannels];
+		Signal rendered;
+		for (uint32_t bufferNum = 0; bufferNum < 1000; ++bufferNum) {
+			audioChip.renderNextSamples(buffer, bufferSize);
+			if (bufferNum >= 10) {
+				for (uint32_t sample = 0; sample < bufferSize; ++sample) {
+					rendered.push_back(buffer[sample * numChannels]);
+				}
+			}
+		}
+		expectAtMost("AudioChip 11025", "sine A4", "pitch cents", calcPitchErrorCents(measureFrequency(rendered, 48000), 440.0), maxResampledPitchErrorCents);
+	}
+
+	// Full chip synthesizing at a reduced internal rate
+	AudioChip::AudioChip audioChip(sampleRate, 1, 22050, AudioChip::Resampler::Quality::Medium, bufferSize);
+	const Patch& patch = patches[0];
+	const Signal rendered = renderChip(audioChip, patch);
+	const Signal sustained(rendered.begin() + 8 * bufferSize, rendered.begin() + patch.noteOffBuffer * bufferSize);
+	expectAtMost("AudioChip 22050", patch.name, "THD+N dB", calcTHDN(sustained, patch.frequency, sampleRate), maxChipTHDN);
+
+	// The filter tail has to run out before the output is reported silent
+	float buffer[bufferSize * numChannels];
+	bool silent = false;
+	for (uint32_t bufferNum = 0; bufferNum < 4 && !silent; ++bufferNum) {
+		silent = audioChip.renderNextSamples(buffer, bufferSize) == AudioChip::Activity::Silent;
+	}
+	report("AudioChip 22050", patch.name, "silent tail", silent ? 1.0 : 0.0, 1.0, silent);
+}
+
+
+/*
+	Sample playback
+*/
+
+const uint32_t sampleAssetRate = 22050;
+const uint32_t sampleAssetFrames = 22050;
+const double sampleToneFrequency = 441.0;
+
+
+/**
+	Reference of a sample track playing a sine tone asset with a full level envelope. The asset is sampled at
+	the exact playback position in double precision, wrapped into the loop when one is given.
+*/
+Signal renderReferenceSample(const double inPositionIncrement, const uint32_t inLoopStart, const uint32_t inLoopEnd, const uint32_t inNumBuffers) {
+	const Patch patch = {"sample", AudioChip::WaveformType::Sample, 0.0f, 0, 0, 126, 0, 0.0f, 0.0f, inNumBuffers, inNumBuffers, 0.0};
+	Signal outSignal(inNumBuffers * bufferSize, 0.0);
+
+	ReferenceEnvelope envelope;
+	double position = 0.0;
+	for (uint32_t buffer = 0; buffer < inNumBuffers; ++buffer) {
+		envelope.advance(patch, bufferSize);
+		for (uint32_t sample = 0; sample < bufferSize; ++sample) {
+			if (inLoopEnd > inLoopStart && position >= inLoopEnd) {
+				position = inLoopStart + fmod(position - inLoopStart, inLoopEnd - inLoopStart);
+			}
+			outSignal[buffer * bufferSize + sample] = 0.5 * sin(pi2 * sampleToneFrequency * position / sampleAssetRate) * envelope.factor;
+			position += inPositionIncrement;
+		}
+	}
+
+	return outSignal;
+}
+
+
+template<typename Chip>
+Signal renderSample(Chip& ioChip, const uint32_t inNumBuffers, const uint32_t inChannel) {
+	Signal outSignal;
+	float buffer[bufferSize * numChannels];
+	for (uint32_t bufferNum = 0; bufferNum < inNumBuffers; ++bufferNum) {
+		ioChip.renderNextSamples(buffer, bufferSize);
+		for (uint32_t sample = 0; sample < bufferSize; ++sample) {
+			outSignal.push_back(buffer[sample * numChannels + inChannel]);
+		}
+	}
+	return outSignal;
+}
+
+
+/**
+	Write inNumFrames frames of inSamples as a mono 16 bit WAV file. Returns false on failure.
+*/
+bool writeWavFile(const char* inPath, const int16_t* inSamples, const uint32_t inNumFrames) {
+	FILE* file = fopen(inPath, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	const uint32_t dataSize = inNumFrames * sizeof(int16_t);
+	const uint32_t riffSize = 36 + dataSize;
+	const uint32_t fmtSize = 16;
+	const uint16_t audioFormat = 1;
+	const uint16_t numWavChannels = 1;
+	const uint32_t byteRate = sampleAssetRate * sizeof(int16_t);
+	const uint16_t blockAlign = sizeof(int16_t);
+	const uint16_t bitsPerSample = 16;
+
+	bool written = fwrite("RIFF", 1, 4, file) == 4;
+	written = written && fwrite(&riffSize, 4, 1, file) == 1;
+	written = written && fwrite("WAVEfmt ", 1, 8, file) == 8;
+	written = written && fwrite(&fmtSize, 4, 1, file) == 1;
+	written = written && fwrite(&audioFormat, 2, 1, file) == 1;
+	written = written && fwrite(&numWavChannels, 2, 1, file) == 1;
+	written = written && fwrite(&sampleAssetRate, 4, 1, file) == 1;
+	written = written && fwrite(&byteRate, 4, 1, file) == 1;
+	written = written && fwrite(&blockAlign, 2, 1, file) == 1;
+	written = written && fwrite(&bitsPerSample, 2, 1, file) == 1;
+	written = written && fwrite("data", 1, 4, file) == 4;
+	written = written && fwrite(&dataSize, 4, 1, file) == 1;
+	written = written && fwrite(inSamples, sizeof(int16_t), inNumFrames, file) == inNumFrames;
+
+	return (fclose(file) == 0) && written;
+}
+
+
+void testSamplePlayback() {
+	std::vector<int16_t> monoData(sampleAssetFrames);
+	std::vector<float> stereoData(sampleAssetFrames * 2);
+	for (uint32_t frame = 0; frame < sampleAssetFrames; ++frame) {
+		const double value = 0.5 * sin(pi2 * sampleToneFrequency * frame / sampleAssetRate);
+		monoData[frame] = static_cast<int16_t>(lround(value * 32767.0));
+		stereoData[frame * 2] = static_cast<float>(value);
+		stereoData[frame * 2 + 1] = static_cast<float>(-value);
+	}
+
+	const std::shared_ptr<const AudioChip::SampleAsset> monoAsset = AudioChip::SampleAsset::fromBuffer(monoData.data(), AudioChip::SampleAsset::Format::Int16, 1, sampleAssetFrames, sampleAssetRate);
+	const std::shared_ptr<const AudioChip::SampleAsset> stereoAsset = AudioChip::SampleAsset::fromBuffer(stereoData.data(), AudioChip::SampleAsset::Format::Float32, 2, sampleAssetFrames, sampleAssetRate);
+
+	// Played at its own rate and pitched up a fifth
+	const float pitchedFrequencies[] = {440.0f, 660.0f};
+	for (const float frequency : pitchedFrequencies) {
+		AudioChip::AudioChip audioChip(sampleRate, 1);
+		audioChip.setWaveformType(0, AudioChip::WaveformType::Sample);
+		audioChip.setSample(0, monoAsset, 440.0f);
+		audioChip.setFrequency(0, frequency);
+		audioChip.noteOn(0);
+
+		const double positionIncrement = (frequency / 440.0) * sampleAssetRate / sampleRate;
+		const Signal reference = renderReferenceSample(positionIncrement, 0, 0, 60);
+		const Signal rendered = renderSample(audioChip, 60, 0);
+		expectAtLeast("sample int16", frequency == 440.0f ? "base pitch" : "fifth up", "SNR dB", calcSNR(reference, rendered), minSampleSNR);
+	}
+
+	// Stereo float sample looping over whole periods, rendered well past the end of the asset
+	{
+		const uint32_t loopStart = 11025;
+		const uint32_t loopEnd = 22050;
+		const uint32_t numBuffers = 400;
+
+		AudioChip::BasicAudioChip<2> basicAudioChip(sampleRate);
+		basicAudioChip.setWaveformType(1, AudioChip::WaveformType::Sample);
+		basicAudioChip.setSample(1, stereoAsset, 440.0f);
+		basicAudioChip.enableSampleLoop(1, loopStart, loopEnd);
+		basicAudioChip.noteOn(1);
+
+		const Signal reference = renderReferenceSample(static_cast<double>(sampleAssetRate) / sampleRate, loopStart, loopEnd, numBuffers);
+		const Signal left = renderSample(basicAudioChip, numBuffers, 0);
+		expectAtLeast("sample float", "stereo loop", "SNR dB", calcSNR(reference, left), minSampleSNR);
+
+		const bool playing = basicAudioChip.getTrackActivity(1) == AudioChip::Activity::Active;
+		report("sample float", "stereo loop", "playing", playing ? 1.0 : 0.0, 1.0, playing);
+	}
+
+	// A sample without loop ends the note at its end
+	{
+		AudioChip::AudioChip audioChip(sampleRate, 1);
+		audioChip.setWaveformType(0, AudioChip::WaveformType::Sample);
+		audioChip.setSample(0, monoAsset, 440.0f);
+		audioChip.noteOn(0);
+
+		const uint32_t numBuffers = (sampleAssetFrames * (sampleRate / sampleAssetRate)) / bufferSize + 2;
+		float buffer[bufferSize * numChannels];
+		AudioChip::Activity activity = AudioChip::Activity::Active;
+		for (uint32_t bufferNum = 0; bufferNum < numBuffers; ++bufferNum) {
+			activity = audioChip.renderNextSamples(buffer, bufferSize);
+		}
+		report("sample int16", "end of sample", "silent", activity == AudioChip::Activity::Silent ? 1.0 : 0.0, 1.0, activity == AudioChip::Activity::Silent);
+	}
+
+	// A memory mapped WAV file shared by two chips, one playing it on two tracks, renders the same as the caller
+	// owned buffer
+	{
+		char path[] = "/tmp/AudioChipReferenceTestXXXXXX";
+		const int fileDescriptor = mkstemp(path);
+		const bool fileCreated = fileDescriptor >= 0 && close(fileDescriptor) == 0 && writeWavFile(path, monoData.data(), sampleAssetFrames);
+		const std::shared_ptr<const AudioChip::SampleAsset> mappedAsset = fileCreated ? AudioChip::SampleAsset::mapWavFile(path) : nullptr;
+		if (fileDescriptor >= 0) {
+			unlink(path);
+		}
+
+		const bool mapped = mappedAsset && mappedAsset->getNumFrames() == sampleAssetFrames && mappedAsset->getSampleRate() == sampleAssetRate &&
+			memcmp(mappedAsset->getData(), monoData.data(), sampleAssetFrames * sizeof(int16_t)) == 0;
+		report("sample mapped", "wav file", "mapped", mapped ? 1.0 : 0.0, 1.0, mapped);
+
+		if (mapped) {
+			AudioChip::AudioChip bufferChip(sampleRate, 1);
+			bufferChip.setWaveformType(0, AudioChip::WaveformType::Sample);
+			bufferChip.setSample(0, monoAsset, 440.0f);
+			bufferChip.noteOn(0);
+
+			AudioChip::AudioChip mappedChip(sampleRate, 2);
+			for (uint32_t track = 0; track < 2; ++track) {
+				mappedChip.setWaveformType(track, AudioChip::WaveformType::Sample);
+				mappedChip.setSample(track, mappedAsset, 440.0f);
+				mappedChip.noteOn(track);
+			}
+
+			AudioChip::BasicAudioChip<1> sharingChip(sampleRate);
+			sharingChip.setWaveformType(0, AudioChip::WaveformType::Sample);
+			sharingChip.setSample(0, mappedAsset, 440.0f);
+			sharingChip.noteOn(0);
+
+			// One reference held here and one per track
+			const long numOwners = mappedAsset.use_count();
+			report("sample mapped", "shared", "owners", static_cast<double>(numOwners), 4.0, numOwners == 4);
+
+			const Signal single = renderSample(bufferChip, 40, 0);
+			Signal doubled = single;
+			for (double& sample : doubled) {
+				sample *= 2.0;
+			}
+			const Signal shared = renderSample(mappedChip, 40, 0);
+			const Signal sharing = renderSample(sharingChip, 40, 0);
+			expectAtLeast("sample mapped", "second chip", "SNR dB", calcSNR(single, sharing), 120.0);
+			expectAtLeast("sample mapped", "two tracks", "SNR dB", calcSNR(doubled, shared), 120.0);
+		}
+	}
+}
+
+
+/**
+	Measure the time from note on until the envelope peaks and from note off until the track is silent, and
+	compare with the nominal stage times. The chip updates its envelope once per buffer, so the error is
+	expected to stay within one buffer.
+*/
+void testEnvelopeTiming() {
+	const uint8_t attack = 20;
+	const uint8_t release = 30;
+	const double nominalAttackMs = envelopeTimePerStep * attack;
+	const double nominalReleaseMs = envelopeTimePerStep * release;
+	const double bufferTimeMs = 1000.0 * bufferSize / sampleRate;
+
+	AudioChip::AudioChip audioChip(sampleRate, 1);
+	audioChip.setEnvelope(0, attack, 0, 126, release);
+	audioChip.noteOn(0);
+
+	float buffer[bufferSize * numChannels];
+	float previousPeak = 0.0f;
+	uint32_t bufferNum = 0;
+	double attackMs = -1.0;
+
+	while (attackMs < 0.0 && bufferNum < 10000) {
+		audioChip.renderNextSamples(buffer, bufferSize);
+		++bufferNum;
+
+		float peak = 0.0f;
+		for (uint32_t sample = 0; sample < bufferSize * numChannels; ++sample) {
+			peak = std::max(peak, fabsf(buffer[sample]));
+		}
+		if (peak <= previousPeak) {
+			attackMs = (bufferNum - 1) * bufferTimeMs;
+		}
+		previousPeak = peak;
+	}
+	expectAtMost("envelope", "attack 20", "error ms", fabs(attackMs - nominalAttackMs), maxEnvelopeTimingErrorMs);
+
+	// Pass the decay stage so that the release starts from full level
+	audioChip.renderNextSamples(buffer, bufferSize);
+	audioChip.renderNextSamples(buffer, bufferSize);
+
+	audioChip.noteOff(0);
+	double releaseMs = -1.0;
+	for (bufferNum = 1; bufferNum < 10000; ++bufferNum) {
+		if (audioChip.renderNextSamples(buffer, bufferSize) == AudioChip::Activity::Silent) {
+			releaseMs = bufferNum * bufferTimeMs;
+			break;
+		}
+	}
+	expectAtMost("envelope", "release 30", "error ms", fabs(releaseMs - nominalReleaseMs), maxEnvelopeTimingErrorMs);
+}
+
+
+} // namespace
+
+
+int main(int /*argc*/, char** /*argv*/) {
+	testSineTable();
+	testGenerators();
+	testChips();
+	testActivity();
+	testEnvelopeTiming();
+	testResampler();
+	testSamplePlayback();
+
+	if (numFailures != 0) {
+		printf("%u checks failed\n", numFailures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}